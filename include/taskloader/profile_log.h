@@ -0,0 +1,95 @@
+#pragma once
+
+#include <base/stdint.h>
+
+// Layout of the profiling log dataspace returned by Taskloader_session::profile_ds().
+//
+// The dataspace starts with a Header followed by header.capacity records (a power of two).
+// The taskloader is the only writer and advances write_pos, the client is the only reader and advances read_pos.
+// Both are free-running record counters, the slot of a position is pos & (capacity - 1).
+// An event is stored as one EVENT record followed by event.num_infos TASK_INFO records. write_pos is only advanced after all of them are complete.
+struct Profile_log
+{
+	enum { CACHE_LINE = 64, SESSION_LEN = 64, THREAD_LEN = 32 };
+
+	enum Event_type { START = 0, EXIT, EXIT_CRITICAL, EXIT_ERROR, EXIT_EXTERNAL, EXTERNAL, DEADLINE_MISS };
+
+	// Kind of a DEADLINE_MISS event.
+	enum Deadline_miss
+	{
+		// Exited regularly after the deadline.
+		MISS_LATE = 0,
+		// Killed at critical time or exited with an error.
+		MISS_KILLED,
+		// Not started because the previous instance was still running.
+		MISS_SKIPPED
+	};
+
+	enum Record_kind { EVENT = 0, TASK_INFO };
+
+	struct Header
+	{
+		// Written by the taskloader.
+		Genode::uint64_t write_pos __attribute__((aligned(CACHE_LINE)));
+
+		// Number of events dropped because the log was full.
+		Genode::uint64_t dropped;
+
+		Genode::uint32_t capacity;
+		Genode::uint32_t record_size;
+
+		// Written by the client.
+		Genode::uint64_t read_pos __attribute__((aligned(CACHE_LINE)));
+	} __attribute__((aligned(CACHE_LINE)));
+
+	struct Event_record
+	{
+		Genode::uint32_t type;
+
+		// Task that triggered this event. -1 for EXTERNAL. 0 for task-manager.
+		Genode::int32_t task_id;
+
+		// Time of trigger in ms.
+		Genode::uint64_t time_stamp;
+
+		// Number of TASK_INFO records following this one.
+		Genode::uint32_t num_infos;
+
+		// Deadline_miss for DEADLINE_MISS events, 0 otherwise.
+		Genode::uint32_t miss;
+
+		// Time in us taken to sample and log this event.
+		Genode::uint32_t sample_cost;
+	};
+
+	struct Task_info_record
+	{
+		// Trace subject id. Pretty much useless.
+		Genode::uint32_t id;
+
+		// Genode::Trace::CPU_info::State
+		Genode::uint32_t state;
+		Genode::uint64_t execution_time;
+
+		// Managed by the task manager. The managed_* fields are only valid if set.
+		Genode::uint32_t managed;
+		Genode::int32_t managed_id;
+		Genode::int32_t managed_iteration;
+		Genode::uint64_t managed_quota;
+		Genode::uint64_t managed_used;
+
+		// Null-terminated, truncated if necessary.
+		char session[SESSION_LEN];
+		char thread[THREAD_LEN];
+	};
+
+	struct Record
+	{
+		Genode::uint32_t kind;
+		union
+		{
+			Event_record event;
+			Task_info_record task_info;
+		};
+	} __attribute__((aligned(CACHE_LINE)));
+};
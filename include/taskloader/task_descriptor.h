@@ -0,0 +1,60 @@
+#pragma once
+
+#include <base/stdint.h>
+
+// Binary task set format accepted by Taskloader_session::add_tasks_binary(), an alternative to the XML description.
+//
+// The dataspace starts with a Header. header.num_tasks records of header.record_size bytes each start at header.records_offset.
+// The config table at header.config_table_offset holds one Config_entry per record, locating the task's <config> node (XML text) in the dataspace.
+// All offsets are relative to the start of the dataspace. Readers accept records of older versions, missing trailing fields get their default.
+struct Task_descriptor
+{
+	enum
+	{
+		MAGIC = 0x4b534154, // "TASK"
+		VERSION = 2,
+		PKG_LEN = 32
+	};
+
+	struct Header
+	{
+		Genode::uint32_t magic;
+		Genode::uint32_t version;
+
+		// Size of the whole descriptor in bytes.
+		Genode::uint32_t size;
+
+		Genode::uint32_t num_tasks;
+		Genode::uint32_t record_size;
+		Genode::uint32_t records_offset;
+		Genode::uint32_t config_table_offset;
+	};
+
+	// Fields correspond to the sub nodes of a <periodictask> node.
+	struct Record
+	{
+		Genode::uint32_t id;
+		Genode::uint32_t execution_time;
+		Genode::uint32_t critical_time;
+		Genode::uint32_t priority;
+		Genode::uint32_t deadline;
+		Genode::uint32_t period;
+		Genode::uint32_t offset;
+		Genode::uint32_t number_of_jobs;
+		Genode::uint64_t quota;
+
+		// Null-terminated.
+		char pkg[PKG_LEN];
+
+		// Since version 2. Task::Description::Overrun, max_queued and the null-terminated fallback binary, empty for none.
+		Genode::uint32_t overrun;
+		Genode::uint32_t max_queued;
+		char fallback_pkg[PKG_LEN];
+	};
+
+	struct Config_entry
+	{
+		Genode::uint32_t offset;
+		Genode::uint32_t size;
+	};
+};
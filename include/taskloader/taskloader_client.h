@@ -14,6 +14,11 @@ struct Taskloader_session_client : Genode::Rpc_client<Taskloader_session>
 		call<Rpc_add_tasks>(xml_ds_cap);
 	}
 
+	void add_tasks_binary(Genode::Ram_dataspace_capability descriptor_ds_cap)
+	{
+		call<Rpc_add_tasks_binary>(descriptor_ds_cap);
+	}
+
 	void clear_tasks()
 	{
 		call<Rpc_clear_tasks>();
@@ -24,6 +29,11 @@ struct Taskloader_session_client : Genode::Rpc_client<Taskloader_session>
 		return call<Rpc_binary_ds>(name_ds_cap, size);
 	}
 
+	void release_binary(Genode::Ram_dataspace_capability name_ds_cap)
+	{
+		call<Rpc_release_binary>(name_ds_cap);
+	}
+
 	void start()
 	{
 		call<Rpc_start>();
@@ -34,4 +44,49 @@ struct Taskloader_session_client : Genode::Rpc_client<Taskloader_session>
 		call<Rpc_stop>();
 	}
 
+	bool remove_task(unsigned id)
+	{
+		return call<Rpc_remove_task>(id);
+	}
+
+	bool update_task(unsigned id, Task_timing timing)
+	{
+		return call<Rpc_update_task>(id, timing);
+	}
+
+	bool start_task(unsigned id)
+	{
+		return call<Rpc_start_task>(id);
+	}
+
+	bool stop_task(unsigned id)
+	{
+		return call<Rpc_stop_task>(id);
+	}
+
+	Genode::Ram_dataspace_capability profile_ds()
+	{
+		return call<Rpc_profile_ds>();
+	}
+
+	Genode::Ram_dataspace_capability timing_ds()
+	{
+		return call<Rpc_timing_ds>();
+	}
+
+	void completion_sigh(Genode::Signal_context_capability sigh)
+	{
+		call<Rpc_completion_sigh>(sigh);
+	}
+
+	unsigned submit(Operation op, Genode::Ram_dataspace_capability ds = Genode::Ram_dataspace_capability())
+	{
+		return call<Rpc_submit>(op, ds);
+	}
+
+	unsigned completed()
+	{
+		return call<Rpc_completed>();
+	}
+
 };
@@ -3,28 +3,85 @@
 #include <session/session.h>
 #include <base/rpc.h>
 #include <ram_session/ram_session.h>
+#include <base/signal.h>
 #include <string>
 
 struct Taskloader_session : Genode::Session
 {
 	static const char *service_name() { return "taskloader"; }
 
+	// Timing parameters of a task, as in the <periodictask> description.
+	struct Task_timing
+	{
+		unsigned execution_time;
+		unsigned critical_time;
+		unsigned priority;
+		unsigned deadline;
+		unsigned period;
+		unsigned offset;
+		unsigned number_of_jobs;
+	};
+
 	virtual void add_tasks(Genode::Ram_dataspace_capability xml_ds_cap) = 0;
+
+	// Same as add_tasks, but with a binary descriptor, see taskloader/task_descriptor.h.
+	virtual void add_tasks_binary(Genode::Ram_dataspace_capability descriptor_ds_cap) = 0;
 	virtual void clear_tasks() = 0;
 	virtual Genode::Ram_dataspace_capability binary_ds(Genode::Ram_dataspace_capability name_ds_cap, size_t size) = 0;
+	virtual void release_binary(Genode::Ram_dataspace_capability name_ds_cap) = 0;
 	virtual void start() = 0;
 	virtual void stop() = 0;
 
+	// Operations on the single task with id. They return false if there is no such task.
+	// The task is stopped and torn down, and its children destroyed, before remove_task and update_task return.
+	virtual bool remove_task(unsigned id) = 0;
+
+	// Change the timing of a task and re-run admission for it. Returns false if it was not admitted. A running task is restarted with the new timing.
+	// If the controller cannot withdraw the old timing, the task is left unchanged and false is returned.
+	virtual bool update_task(unsigned id, Task_timing timing) = 0;
+	virtual bool start_task(unsigned id) = 0;
+	virtual bool stop_task(unsigned id) = 0;
+
+	// Dataspace holding the profiling log, see taskloader/profile_log.h.
+	virtual Genode::Ram_dataspace_capability profile_ds() = 0;
+
+	// Dataspace holding a fresh snapshot of the timing histograms of all tasks, see taskloader/timing_snapshot.h.
+	// The same dataspace is reused by later calls unless the task set outgrows it.
+	virtual Genode::Ram_dataspace_capability timing_ds() = 0;
+
+	// Asynchronous variants of the calls above. They are queued and executed in order on the taskloader entrypoint, so the caller never blocks it.
+	enum Operation { ADD_TASKS, ADD_TASKS_BINARY, CLEAR_TASKS, START, STOP };
+
+	// Signal delivered whenever queued operations have completed.
+	virtual void completion_sigh(Genode::Signal_context_capability sigh) = 0;
+
+	// Queue an operation and return its ticket. ds is the argument of ADD_TASKS and ADD_TASKS_BINARY and must stay valid until completion.
+	virtual unsigned submit(Operation op, Genode::Ram_dataspace_capability ds) = 0;
+
+	// Ticket of the last completed operation. Tickets start at 1 and complete in order.
+	virtual unsigned completed() = 0;
+
 	/*******************
 	 ** RPC interface **
 	 *******************/
 	GENODE_RPC(Rpc_add_tasks, void, add_tasks, Genode::Ram_dataspace_capability);
+	GENODE_RPC(Rpc_add_tasks_binary, void, add_tasks_binary, Genode::Ram_dataspace_capability);
 	GENODE_RPC(Rpc_clear_tasks, void, clear_tasks);
 	GENODE_RPC(Rpc_binary_ds, Genode::Ram_dataspace_capability, binary_ds, Genode::Ram_dataspace_capability, size_t);
+	GENODE_RPC(Rpc_release_binary, void, release_binary, Genode::Ram_dataspace_capability);
 	GENODE_RPC(Rpc_start, void, start);
 	GENODE_RPC(Rpc_stop, void, stop);
-	
+	GENODE_RPC(Rpc_remove_task, bool, remove_task, unsigned);
+	GENODE_RPC(Rpc_update_task, bool, update_task, unsigned, Task_timing);
+	GENODE_RPC(Rpc_start_task, bool, start_task, unsigned);
+	GENODE_RPC(Rpc_stop_task, bool, stop_task, unsigned);
+	GENODE_RPC(Rpc_profile_ds, Genode::Ram_dataspace_capability, profile_ds);
+	GENODE_RPC(Rpc_timing_ds, Genode::Ram_dataspace_capability, timing_ds);
+	GENODE_RPC(Rpc_completion_sigh, void, completion_sigh, Genode::Signal_context_capability);
+	GENODE_RPC(Rpc_submit, unsigned, submit, Operation, Genode::Ram_dataspace_capability);
+	GENODE_RPC(Rpc_completed, unsigned, completed);
+
 
 
-	GENODE_RPC_INTERFACE(Rpc_add_tasks, Rpc_clear_tasks, Rpc_binary_ds, Rpc_start, Rpc_stop);
+	GENODE_RPC_INTERFACE(Rpc_add_tasks, Rpc_add_tasks_binary, Rpc_clear_tasks, Rpc_binary_ds, Rpc_release_binary, Rpc_start, Rpc_stop, Rpc_remove_task, Rpc_update_task, Rpc_start_task, Rpc_stop_task, Rpc_profile_ds, Rpc_timing_ds, Rpc_completion_sigh, Rpc_submit, Rpc_completed);
 };
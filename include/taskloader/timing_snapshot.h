@@ -0,0 +1,173 @@
+#pragma once
+
+#include <base/stdint.h>
+
+// Layout of the timing snapshot dataspace returned by Taskloader_session::timing_ds().
+//
+// The dataspace starts with a Header, including the cost of taskloader operations, followed by header.num_tasks entries of header.entry_size bytes each.
+// All times are in us. Histograms are log-linear: values below SUB_BUCKETS have a bucket each, every following power of two is split into SUB_BUCKETS equal buckets.
+// This bounds the relative error to 1 / SUB_BUCKETS over the whole range. Values of 2^32 us and above are only counted in overflow.
+struct Timing_snapshot
+{
+	enum
+	{
+		SUB_BUCKET_BITS = 3,
+		SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+		MAX_BITS = 32,
+		NUM_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+	};
+
+	// Measured taskloader operations.
+	enum Operation
+	{
+		// One add_tasks or add_tasks_binary call, header.tasks_added counts the tasks.
+		OP_ADD_TASKS = 0,
+		// One binary_ds call, header.bytes_uploaded counts the requested sizes.
+		OP_BINARY_DS,
+		// Sampling and logging one profiling event, see Profile_log::Event_record::sample_cost.
+		OP_LOG_EVENT,
+		// One clear_tasks call including the teardown of all children.
+		OP_CLEAR_TASKS,
+		// One start call.
+		OP_START,
+		NUM_OPERATIONS
+	};
+
+	struct Histogram
+	{
+		Genode::uint32_t count;
+		Genode::uint32_t overflow;
+
+		// Exact extremes and sum of all values, including overflows. Undefined if count is 0.
+		Genode::uint64_t min;
+		Genode::uint64_t max;
+		Genode::uint64_t total;
+
+		Genode::uint32_t buckets[NUM_BUCKETS];
+	};
+
+	// Outcome of all jobs, see Profile_log::Deadline_miss. The deadline is relative to the release, the period if none is given.
+	struct Deadline_counts
+	{
+		Genode::uint32_t on_time;
+		Genode::uint32_t late;
+		Genode::uint32_t killed;
+		Genode::uint32_t skipped;
+	};
+
+	// Outcomes of releases that found the previous instance still running, see the <overrun> node of a task. Skipped releases are counted in Deadline_counts.
+	struct Overrun_counts
+	{
+		// Queued for later start, or dropped because the queue was full.
+		Genode::uint32_t queued;
+		Genode::uint32_t dropped;
+
+		// Previous instance killed for the release, with the regular or the fallback binary.
+		Genode::uint32_t restarted;
+		Genode::uint32_t degraded;
+	};
+
+	// Jobs that exceeded their CPU budget with <release budget="cpu"/>, by budget action.
+	struct Budget_counts
+	{
+		Genode::uint32_t killed;
+		Genode::uint32_t flagged;
+	};
+
+	// Execution time estimate from the CPU time of past jobs, see the <wcet-estimate> config node.
+	struct Wcet_estimate
+	{
+		// Moving average and configured percentile of the CPU time in us.
+		Genode::uint64_t average;
+		Genode::uint64_t percentile;
+
+		// Execution time in ms as specified for the task, and as currently offered to the controller.
+		Genode::uint32_t specified;
+		Genode::uint32_t admitted;
+	};
+
+	// Criticality mode switches, see the <mixed-criticality> config node.
+	struct Mode_counts
+	{
+		// 1 while in HI mode.
+		Genode::uint32_t hi;
+
+		Genode::uint32_t hi_switches;
+		Genode::uint32_t lo_switches;
+
+		// Releases of low-criticality tasks in HI mode, dropped or started with the fallback binary.
+		Genode::uint32_t lo_dropped;
+		Genode::uint32_t lo_degraded;
+
+		// Total time spent in HI mode.
+		Genode::uint64_t hi_time;
+
+		// Deadline miss or budget overrun of a high-criticality task to HI mode.
+		Histogram switch_latency;
+	};
+
+	struct Header
+	{
+		// Time the snapshot was taken.
+		Genode::uint64_t time_stamp;
+
+		Genode::uint32_t num_tasks;
+		Genode::uint32_t entry_size;
+		Genode::uint32_t num_buckets;
+		Genode::uint32_t sub_bucket_bits;
+
+		Genode::uint64_t tasks_added;
+		Genode::uint64_t bytes_uploaded;
+
+		// Duration of each Operation, since the taskloader was started.
+		Histogram operations[NUM_OPERATIONS];
+
+		Mode_counts mode;
+	};
+
+	struct Task_entry
+	{
+		Genode::uint32_t task_id;
+		Genode::uint32_t jobs;
+
+		// Release timeout to running child.
+		Histogram release_latency;
+
+		// Release to regular exit.
+		Histogram response_time;
+
+		// Deviation of the interval between two job starts from the period (times the number of jobs in between).
+		Histogram start_jitter;
+
+		Deadline_counts deadlines;
+		Overrun_counts overruns;
+
+		// CPU time consumed by each job as last sampled from its trace subjects.
+		Histogram cpu_time;
+
+		Budget_counts budget;
+		Wcet_estimate wcet;
+	};
+
+	// Bucket of a value below 2^MAX_BITS.
+	static unsigned bucket(Genode::uint64_t value)
+	{
+		if (value < SUB_BUCKETS)
+		{
+			return (unsigned)value;
+		}
+		const unsigned msb = 63 - __builtin_clzll(value);
+		return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (unsigned)((value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+	}
+
+	// Smallest value of a bucket.
+	static Genode::uint64_t bucket_min(unsigned bucket)
+	{
+		if (bucket < SUB_BUCKETS)
+		{
+			return bucket;
+		}
+		const unsigned msb = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+		return (Genode::uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (msb - SUB_BUCKET_BITS);
+	}
+};
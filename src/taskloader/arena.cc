@@ -0,0 +1,116 @@
+#include "arena.h"
+
+#include <base/env.h>
+#include <base/printf.h>
+
+Arena::Arena(const Genode::Xml_node& config) :
+	_chunk_size{_chunk_size_from_config(config)},
+	_chunks{nullptr},
+	_free{nullptr},
+	_used{0}
+{
+}
+
+Arena::~Arena()
+{
+	while (_chunks)
+	{
+		Chunk* chunk = _chunks;
+		_chunks = chunk->next;
+		_release_chunk(chunk);
+	}
+}
+
+void* Arena::alloc(size_t size, size_t align)
+{
+	// Every block must be able to hold a Free_block once it is freed.
+	size = size < sizeof(Free_block) ? sizeof(Free_block) : size;
+
+	for (Free_block** block = &_free; *block; block = &(*block)->next)
+	{
+		if ((*block)->size == size && ((Genode::addr_t)*block & (align - 1)) == 0)
+		{
+			void* addr = *block;
+			*block = (*block)->next;
+			_used += size;
+			return addr;
+		}
+	}
+
+	size_t top = _chunks ? (_chunks->top + align - 1) & ~(align - 1) : 0;
+	if (!_chunks || top + size > _chunks->size)
+	{
+		Chunk* chunk = _new_chunk(sizeof(Chunk) + align + size);
+		chunk->next = _chunks;
+		_chunks = chunk;
+		top = (chunk->top + align - 1) & ~(align - 1);
+	}
+
+	_chunks->top = top + size;
+	_used += size;
+	return (char*)_chunks + top;
+}
+
+void Arena::free(void* addr, size_t size)
+{
+	size = size < sizeof(Free_block) ? sizeof(Free_block) : size;
+
+	Free_block* block = static_cast<Free_block*>(addr);
+	block->size = size;
+	block->next = _free;
+	_free = block;
+	_used -= size;
+}
+
+void Arena::reset()
+{
+	_free = nullptr;
+	_used = 0;
+	if (!_chunks)
+	{
+		return;
+	}
+
+	// The oldest chunk is at the end of the list.
+	while (_chunks->next)
+	{
+		Chunk* chunk = _chunks;
+		_chunks = chunk->next;
+		_release_chunk(chunk);
+	}
+	_chunks->top = sizeof(Chunk);
+}
+
+size_t Arena::used() const
+{
+	return _used;
+}
+
+Arena::Chunk* Arena::_new_chunk(size_t min_size)
+{
+	const size_t size = min_size > _chunk_size ? min_size : _chunk_size;
+	Genode::Ram_dataspace_capability ds = Genode::env()->ram_session()->alloc(size);
+	Chunk* chunk = Genode::env()->rm_session()->attach(ds);
+	chunk->ds = ds;
+	chunk->next = nullptr;
+	chunk->size = size;
+	chunk->top = sizeof(Chunk);
+	return chunk;
+}
+
+size_t Arena::_chunk_size_from_config(const Genode::Xml_node& config)
+{
+	const size_t default_size = 64 * 1024;
+	if (!config.has_sub_node("arena"))
+	{
+		return default_size;
+	}
+	return config.sub_node("arena").attribute_value<Genode::Number_of_bytes>("chunk", default_size);
+}
+
+void Arena::_release_chunk(Chunk* chunk)
+{
+	const Genode::Ram_dataspace_capability ds = chunk->ds;
+	Genode::env()->rm_session()->detach(chunk);
+	Genode::env()->ram_session()->free(ds);
+}
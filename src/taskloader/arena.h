@@ -0,0 +1,132 @@
+#pragma once
+
+#include <new>
+
+#include <base/stdint.h>
+#include <ram_session/ram_session.h>
+#include <util/noncopyable.h>
+#include <util/xml_node.h>
+
+// Bump allocator backed by RAM dataspaces, for objects that live until the task set is cleared.
+// Memory is taken from chunks of the size set in the <arena chunk="..."/> config node. Freed blocks are only reused by allocations of the same size, everything else is returned at once by reset().
+// Not thread-safe.
+class Arena : Genode::Noncopyable
+{
+public:
+	Arena(const Genode::Xml_node& config);
+	~Arena();
+
+	void* alloc(size_t size, size_t align = sizeof(long));
+	void free(void* addr, size_t size);
+
+	// Drop all allocations. Keeps the first chunk for reuse and releases the others.
+	void reset();
+
+	// Bytes handed out and not freed since the last reset.
+	size_t used() const;
+
+protected:
+	// Header at the start of each chunk.
+	struct Chunk
+	{
+		Genode::Ram_dataspace_capability ds;
+		Chunk* next;
+		size_t size;
+		size_t top;
+	};
+
+	// Freed block, linked through its own memory.
+	struct Free_block
+	{
+		Free_block* next;
+		size_t size;
+	};
+
+	const size_t _chunk_size;
+	Chunk* _chunks;
+	Free_block* _free;
+	size_t _used;
+
+	Chunk* _new_chunk(size_t min_size);
+	void _release_chunk(Chunk* chunk);
+
+	static size_t _chunk_size_from_config(const Genode::Xml_node& config);
+};
+
+// STL allocator adapter for Arena.
+template <typename T>
+class Arena_allocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef long difference_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef Arena_allocator<U> other;
+	};
+
+	Arena_allocator(Arena& arena) :
+		_arena{&arena}
+	{
+	}
+
+	template <typename U>
+	Arena_allocator(const Arena_allocator<U>& other) :
+		_arena{other.arena()}
+	{
+	}
+
+	T* allocate(size_t n)
+	{
+		return static_cast<T*>(_arena->alloc(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		_arena->free(p, n * sizeof(T));
+	}
+
+	template <typename U, typename... ARGS>
+	void construct(U* p, ARGS&&... args)
+	{
+		::new ((void*)p) U(static_cast<ARGS&&>(args)...);
+	}
+
+	template <typename U>
+	void destroy(U* p)
+	{
+		p->~U();
+	}
+
+	size_t max_size() const
+	{
+		return ~(size_t)0 / sizeof(T);
+	}
+
+	Arena* arena() const
+	{
+		return _arena;
+	}
+
+	template <typename U>
+	bool operator==(const Arena_allocator<U>& other) const
+	{
+		return _arena == other.arena();
+	}
+
+	template <typename U>
+	bool operator!=(const Arena_allocator<U>& other) const
+	{
+		return _arena != other.arena();
+	}
+
+private:
+	Arena* _arena;
+};
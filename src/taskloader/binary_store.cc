@@ -0,0 +1,285 @@
+#include "binary_store.h"
+
+#include <base/env.h>
+#include <base/printf.h>
+#include <util/string.h>
+
+#include "fnv.h"
+
+Binary_store::Blob::Blob(size_t size) :
+	ds{Genode::env()->ram_session(), size},
+	size{size},
+	hash{0},
+	sealed{false},
+	elf{},
+	names{0},
+	tasks{0},
+	pinned{false},
+	last_use{0}
+{
+}
+
+
+
+Binary_store::Binary_store(const Genode::Xml_node& config) :
+	_lock{},
+	_budget{0},
+	_used{0},
+	_tick{0},
+	_blobs{},
+	_names{},
+	_pins{},
+	_by_hash{}
+{
+	if (config.has_sub_node("binaries"))
+	{
+		_budget = config.sub_node("binaries").attribute_value<Genode::Number_of_bytes>("budget", 0);
+	}
+}
+
+Genode::Ram_dataspace_capability Binary_store::upload(const char* name, size_t size)
+{
+	Genode::Lock::Guard guard(_lock);
+
+	if (Genode::strlen(name) >= Task_descriptor::PKG_LEN)
+	{
+		PWRN("Binary name %s is longer than %u characters, storing it truncated.", name, Task_descriptor::PKG_LEN - 1);
+	}
+
+	// Replace a previous binary of the same name, even if the size matches, as the content may differ.
+	auto it = _names.find(Name(name));
+	if (it != _names.end())
+	{
+		Blob* old = it->second;
+		_names.erase(it);
+		_unref_name(old);
+	}
+
+	_make_room(size);
+
+	_blobs.emplace_back(size);
+	Blob& blob = _blobs.back();
+	blob.names = 1;
+	blob.last_use = ++_tick;
+	_used += size;
+	_names.emplace(Name(name), &blob);
+	return blob.ds.cap();
+}
+
+Binary_store::Blob* Binary_store::acquire(const char* name)
+{
+	Genode::Lock::Guard guard(_lock);
+
+	auto it = _names.find(Name(name));
+	if (it == _names.end())
+	{
+		return nullptr;
+	}
+
+	Blob* blob = _seal(it->second);
+	++blob->tasks;
+	blob->last_use = ++_tick;
+	return blob;
+}
+
+void Binary_store::release(Blob* blob)
+{
+	Genode::Lock::Guard guard(_lock);
+	--blob->tasks;
+	_free_if_unused(blob);
+}
+
+bool Binary_store::remove(const char* name)
+{
+	Genode::Lock::Guard guard(_lock);
+
+	auto it = _names.find(Name(name));
+	if (it == _names.end())
+	{
+		return false;
+	}
+	Blob* blob = it->second;
+	_names.erase(it);
+	_unref_name(blob);
+	return true;
+}
+
+void Binary_store::pin(const char* name)
+{
+	Genode::Lock::Guard guard(_lock);
+	++_pins[Name(name)];
+}
+
+void Binary_store::unpin(const char* name)
+{
+	Genode::Lock::Guard guard(_lock);
+	auto it = _pins.find(Name(name));
+	if (it != _pins.end() && --it->second == 0)
+	{
+		_pins.erase(it);
+	}
+}
+
+void Binary_store::seal_all()
+{
+	Genode::Lock::Guard guard(_lock);
+	for (auto& name : _names)
+	{
+		_seal(name.second);
+	}
+}
+
+size_t Binary_store::used() const
+{
+	Genode::Lock::Guard guard(_lock);
+	return _used;
+}
+
+Binary_store::Blob* Binary_store::_seal(Blob* blob)
+{
+	if (blob->sealed)
+	{
+		return blob;
+	}
+
+	blob->hash = Fnv::hash(blob->ds.local_addr<char>(), blob->size);
+
+	auto range = _by_hash.equal_range(blob->hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		Blob* other = it->second;
+		if (other->size != blob->size || Genode::memcmp(other->ds.local_addr<char>(), blob->ds.local_addr<char>(), blob->size) != 0)
+		{
+			continue;
+		}
+
+		// Identical content. Move all names over and drop the new copy.
+		for (auto& name : _names)
+		{
+			if (name.second == blob)
+			{
+				name.second = other;
+				++other->names;
+			}
+		}
+		PINF("Binary of %u bytes is identical to a stored one, sharing it.", blob->size);
+		other->last_use = ++_tick;
+		blob->names = 0;
+		_free_if_unused(blob);
+		return other;
+	}
+
+	blob->elf.parse(blob->ds.local_addr<char>(), blob->size);
+	if (blob->elf.valid)
+	{
+		PINF("Binary of %u bytes: %s, %u segments, %u bytes shared read-only.", blob->size, blob->elf.dynamic ? "dynamic" : "static", blob->elf.num_segments, blob->elf.shared_size());
+	}
+	else
+	{
+		PWRN("Binary of %u bytes is no valid ELF image.", blob->size);
+	}
+
+	blob->sealed = true;
+	_by_hash.emplace(blob->hash, blob);
+	return blob;
+}
+
+void Binary_store::_unref_name(Blob* blob)
+{
+	--blob->names;
+	_free_if_unused(blob);
+}
+
+void Binary_store::_free_if_unused(Blob* blob)
+{
+	if (blob->names > 0 || blob->tasks > 0)
+	{
+		return;
+	}
+
+	if (blob->sealed)
+	{
+		auto range = _by_hash.equal_range(blob->hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second == blob)
+			{
+				_by_hash.erase(it);
+				break;
+			}
+		}
+	}
+
+	_used -= blob->size;
+	for (auto it = _blobs.begin(); it != _blobs.end(); ++it)
+	{
+		if (&*it == blob)
+		{
+			_blobs.erase(it);
+			break;
+		}
+	}
+}
+
+void Binary_store::_make_room(size_t size)
+{
+	if (_budget == 0)
+	{
+		return;
+	}
+
+	// Binaries of loaded tasks stay, even while no instance runs.
+	for (Blob& blob : _blobs)
+	{
+		blob.pinned = false;
+	}
+	for (auto& name : _names)
+	{
+		if (_pins.find(name.first) != _pins.end())
+		{
+			name.second->pinned = true;
+		}
+	}
+
+	while (_used + size > _budget)
+	{
+		Blob* lru = nullptr;
+		for (Blob& blob : _blobs)
+		{
+			if (blob.tasks == 0 && !blob.pinned && (!lru || blob.last_use < lru->last_use))
+			{
+				lru = &blob;
+			}
+		}
+		if (!lru)
+		{
+			PWRN("Binary budget of %u bytes exceeded, but all binaries are in use.", _budget);
+			return;
+		}
+
+		for (auto it = _names.begin(); it != _names.end();)
+		{
+			if (it->second == lru)
+			{
+				PINF("Evicting binary %s.", it->first.string());
+				it = _names.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+		lru->names = 0;
+		_free_if_unused(lru);
+	}
+}
+
+size_t Binary_store::Name_hash::operator()(const Name& name) const
+{
+	return Fnv::hash(name.string());
+}
+
+bool Binary_store::Name_equal::operator()(const Name& a, const Name& b) const
+{
+	return Genode::strcmp(a.string(), b.string()) == 0;
+}
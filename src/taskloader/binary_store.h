@@ -0,0 +1,106 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+
+#include <base/lock.h>
+#include <base/stdint.h>
+#include <os/attached_ram_dataspace.h>
+#include <util/noncopyable.h>
+#include <util/string.h>
+#include <util/xml_node.h>
+#include <taskloader/task_descriptor.h>
+
+#include "elf_info.h"
+
+// Task binaries, stored by content so identical images uploaded under different names share one dataspace.
+//
+// A binary is uploaded into a fresh dataspace. Its content is hashed ("sealed") when it is first used, after which it is immutable and deduplicated against all other sealed binaries.
+// Binaries are kept while a name refers to them or a task uses them. Under the RAM budget set in the <binaries> config node, the least recently used binaries without tasks are evicted.
+// All methods are thread-safe.
+class Binary_store : Genode::Noncopyable
+{
+public:
+	struct Blob
+	{
+		Blob(size_t size);
+
+		Genode::Attached_ram_dataspace ds;
+		const size_t size;
+
+		// Content hash, valid once sealed.
+		Genode::uint64_t hash;
+		bool sealed;
+
+		// ELF metadata, valid once sealed. Parsed once per content instead of on every release.
+		Elf_info elf;
+
+		// Number of names and running task instances referring to this binary.
+		unsigned names;
+		unsigned tasks;
+
+		// A name of the binary is pinned. Only valid during eviction.
+		bool pinned;
+
+		// Time of last upload or acquire, for LRU eviction.
+		unsigned long long last_use;
+	};
+
+	// Binary names are at most as long as the pkg field of a task description.
+	typedef Genode::String<Task_descriptor::PKG_LEN> Name;
+
+	Binary_store(const Genode::Xml_node& config);
+
+	// Dataspace to upload the binary called name into. Replaces the binary previously uploaded under that name.
+	Genode::Ram_dataspace_capability upload(const char* name, size_t size);
+
+	// Binary called name, sealed and referenced by the caller until release(). Returns nullptr if there is none.
+	Blob* acquire(const char* name);
+	void release(Blob* blob);
+
+	// Forget the name. The binary is freed once nothing refers to it. Returns false if the name is unknown.
+	bool remove(const char* name);
+
+	// Keep the binary called name from being evicted, e.g. while a task using it is loaded. Pins are counted and may precede the upload.
+	void pin(const char* name);
+	void unpin(const char* name);
+
+	// Seal all binaries, e.g. once uploads are known to be complete.
+	void seal_all();
+
+	// RAM used by all binaries.
+	size_t used() const;
+
+protected:
+	mutable Genode::Lock _lock;
+	size_t _budget;
+	size_t _used;
+	unsigned long long _tick;
+
+	// List so blobs and their dataspaces never move.
+	std::list<Blob> _blobs;
+	// Keyed by fixed-size names, so lookups on release do not allocate.
+	struct Name_hash
+	{
+		size_t operator()(const Name& name) const;
+	};
+
+	struct Name_equal
+	{
+		bool operator()(const Name& a, const Name& b) const;
+	};
+
+	std::unordered_map<Name, Blob*, Name_hash, Name_equal> _names;
+	std::unordered_map<Name, unsigned, Name_hash, Name_equal> _pins;
+	std::unordered_multimap<Genode::uint64_t, Blob*> _by_hash;
+
+	// Hash the content and merge it into an identical sealed blob if there is one. Returns the surviving blob.
+	Blob* _seal(Blob* blob);
+
+	// Drop one reference and free the blob if it was the last.
+	void _unref_name(Blob* blob);
+	void _free_if_unused(Blob* blob);
+
+	// Evict least recently used blobs without tasks until size more bytes fit into the budget.
+	void _make_room(size_t size);
+};
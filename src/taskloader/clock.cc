@@ -0,0 +1,39 @@
+#include "clock.h"
+
+#include <base/printf.h>
+
+Clock::Clock(Timer::Connection& timer) :
+	_timer(timer),
+	_base_ts{0},
+	_base_ms{0},
+	_ticks_per_ms{0}
+{
+	// Start at a ms edge so the base time stamp is as close as possible to the base time.
+	const unsigned long start_ms = _timer.elapsed_ms();
+	while ((_base_ms = _timer.elapsed_ms()) == start_ms);
+	_base_ts = Genode::Trace::timestamp();
+
+	_timer.msleep(CALIBRATION_MS);
+	const unsigned long end_ms = _timer.elapsed_ms();
+	const Genode::Trace::Timestamp end_ts = Genode::Trace::timestamp();
+
+	if (end_ts > _base_ts && end_ms > _base_ms)
+	{
+		_ticks_per_ms = (end_ts - _base_ts) / (end_ms - _base_ms);
+	}
+
+	if (_ticks_per_ms < 1000)
+	{
+		PWRN("No usable time stamp counter, time stamps have ms resolution.");
+		_ticks_per_ms = 0;
+	}
+}
+
+unsigned long long Clock::now_us()
+{
+	if (_ticks_per_ms == 0)
+	{
+		return (unsigned long long)_timer.elapsed_ms() * 1000;
+	}
+	return (unsigned long long)_base_ms * 1000 + (Genode::Trace::timestamp() - _base_ts) * 1000 / _ticks_per_ms;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <timer_session/connection.h>
+#include <trace/timestamp.h>
+
+// Microsecond time stamps on the time base of a timer session.
+// Uses the CPU time stamp counter, calibrated against the timer once at construction. Falls back to the ms resolution of the timer if there is no usable time stamp counter.
+class Clock
+{
+public:
+	// Blocks for the calibration period.
+	Clock(Timer::Connection& timer);
+
+	unsigned long long now_us();
+
+protected:
+	enum { CALIBRATION_MS = 100 };
+
+	Timer::Connection& _timer;
+	Genode::Trace::Timestamp _base_ts;
+	unsigned long _base_ms;
+
+	// 0 if the time stamp counter is not used.
+	unsigned long long _ticks_per_ms;
+};
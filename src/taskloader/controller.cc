@@ -0,0 +1,199 @@
+#include "controller.h"
+
+#include <base/env.h>
+#include <base/printf.h>
+
+Controller* Controller::create(const Genode::Xml_node& config)
+{
+	if (!config.has_sub_node("controller"))
+	{
+		return new (Genode::env()->heap()) Remote_controller();
+	}
+
+	const Genode::Xml_node node = config.sub_node("controller");
+	if (!node.has_attribute("mode"))
+	{
+		return new (Genode::env()->heap()) Remote_controller();
+	}
+
+	const Genode::Xml_node::Attribute mode = node.attribute("mode");
+	if (mode.has_value("accept-all"))
+	{
+		return new (Genode::env()->heap()) Stub_controller(node, Stub_controller::ACCEPT_ALL);
+	}
+	if (mode.has_value("utilization"))
+	{
+		return new (Genode::env()->heap()) Stub_controller(node, Stub_controller::UTILIZATION);
+	}
+	if (mode.has_value("scripted"))
+	{
+		return new (Genode::env()->heap()) Stub_controller(node, Stub_controller::SCRIPTED);
+	}
+	if (!mode.has_value("remote"))
+	{
+		PWRN("Unknown controller mode, using the sched-controller service.");
+	}
+	return new (Genode::env()->heap()) Remote_controller();
+}
+
+
+
+void Remote_controller::update_rq_buffer(unsigned core)
+{
+	_connection.update_rq_buffer(core);
+}
+
+int Remote_controller::new_task(const Rq_task::Rq_task& task, unsigned core)
+{
+	return _connection.new_task(task, core);
+}
+
+void Remote_controller::optimize(const Task_name& name)
+{
+	_connection.optimize(name);
+}
+
+int Remote_controller::scheduling_allowed(const Task_name& name)
+{
+	return _connection.scheduling_allowed(name);
+}
+
+void Remote_controller::last_job_started(const Task_name& name)
+{
+	_connection.last_job_started(name);
+}
+
+bool Remote_controller::withdraw(unsigned, unsigned)
+{
+	return false;
+}
+
+void Remote_controller::reset()
+{
+}
+
+
+
+Stub_controller::Stub_controller(const Genode::Xml_node& node, Mode mode) :
+	_mode{mode},
+	_latency_us{node.attribute_value<unsigned>("latency-us", 0)},
+	_bound{node.attribute_value<unsigned>("bound", 100)},
+	_timer{},
+	_accepted{},
+	_utilization{},
+	_verdicts{},
+	_num_verdicts{0}
+{
+	const auto fn = [this] (const Genode::Xml_node& verdict)
+	{
+		if (_num_verdicts == MAX_VERDICTS)
+		{
+			PWRN("Too many scripted controller verdicts, ignoring the rest.");
+			return;
+		}
+		_verdicts[_num_verdicts++] = {verdict.attribute_value<unsigned>("id", 0), verdict.attribute_value<bool>("accept", true), verdict.attribute_value<int>("allowed", 1)};
+	};
+	node.for_each_sub_node("verdict", fn);
+
+	PINF("Using in-process controller, %u us latency per call.", _latency_us);
+}
+
+void Stub_controller::update_rq_buffer(unsigned)
+{
+	_delay();
+}
+
+int Stub_controller::new_task(const Rq_task::Rq_task& task, unsigned core)
+{
+	_delay();
+	switch (_mode)
+	{
+		case UTILIZATION:
+		{
+			// A task submitted again replaces its previous parameters.
+			withdraw(task.task_id, core);
+			const double utilization = task.inter_arrival > 0 ? (double)task.wcet / task.inter_arrival : 0.0;
+			if (core >= Core_placement::MAX_CORES || (_utilization[core] + utilization) * 100 > _bound)
+			{
+				return 1;
+			}
+			_utilization[core] += utilization;
+			_accepted[task.task_id] = Accepted{core, utilization};
+			return 0;
+		}
+		case SCRIPTED:
+		{
+			const Verdict* verdict = _verdict(task.task_id);
+			return !verdict || verdict->accept ? 0 : 1;
+		}
+		default:
+			return 0;
+	}
+}
+
+void Stub_controller::optimize(const Task_name&)
+{
+	_delay();
+}
+
+int Stub_controller::scheduling_allowed(const Task_name& name)
+{
+	_delay();
+	const Verdict* verdict = _mode == SCRIPTED ? _verdict(_id(name)) : nullptr;
+	return verdict ? verdict->allowed : 1;
+}
+
+void Stub_controller::last_job_started(const Task_name&)
+{
+	_delay();
+}
+
+bool Stub_controller::withdraw(unsigned task_id, unsigned)
+{
+	auto it = _accepted.find(task_id);
+	if (it != _accepted.end())
+	{
+		_utilization[it->second.core] -= it->second.utilization;
+		_accepted.erase(it);
+	}
+	return true;
+}
+
+void Stub_controller::reset()
+{
+	_accepted.clear();
+	for (double& utilization : _utilization)
+	{
+		utilization = 0.0;
+	}
+}
+
+void Stub_controller::_delay()
+{
+	if (_latency_us > 0)
+	{
+		_timer.usleep(_latency_us);
+	}
+}
+
+const Stub_controller::Verdict* Stub_controller::_verdict(unsigned id) const
+{
+	for (unsigned i = 0; i < _num_verdicts; ++i)
+	{
+		if (_verdicts[i].id == id)
+		{
+			return &_verdicts[i];
+		}
+	}
+	return nullptr;
+}
+
+unsigned Stub_controller::_id(const Task_name& name)
+{
+	unsigned id = 0;
+	for (const char* c = name.string(); *c >= '0' && *c <= '9'; ++c)
+	{
+		id = id * 10 + (*c - '0');
+	}
+	return id;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <unordered_map>
+
+#include <timer_session/connection.h>
+#include <util/noncopyable.h>
+#include <util/string.h>
+#include <util/xml_node.h>
+#include "sched_controller_session/connection.h"
+
+#include "placement.h"
+
+// Scheduling controller as used for admission and job permissions, selected by the mode attribute of the <controller> config node.
+// "remote" (default) forwards to the sched-controller service. The other modes decide in-process, so the taskloader can be measured and tested without that service.
+class Controller : Genode::Noncopyable
+{
+public:
+	typedef Genode::String<32> Task_name;
+
+	virtual ~Controller() { }
+
+	virtual void update_rq_buffer(unsigned core) = 0;
+
+	// 0 if the task is accepted on core.
+	virtual int new_task(const Rq_task::Rq_task& task, unsigned core) = 0;
+
+	virtual void optimize(const Task_name& name) = 0;
+
+	// >0 if the next job may start, 0 if not, <0 if the task is unknown.
+	virtual int scheduling_allowed(const Task_name& name) = 0;
+
+	virtual void last_job_started(const Task_name& name) = 0;
+
+	// Forget a task accepted on core, e.g. before it is removed or submitted with new parameters. False if the controller cannot withdraw tasks.
+	virtual bool withdraw(unsigned task_id, unsigned core) = 0;
+
+	// Forget all tasks.
+	virtual void reset() = 0;
+
+	// Controller for the config. Allocated on the heap.
+	static Controller* create(const Genode::Xml_node& config);
+};
+
+// Forwards everything to the sched-controller service.
+class Remote_controller : public Controller
+{
+public:
+	void update_rq_buffer(unsigned core) override;
+	int new_task(const Rq_task::Rq_task& task, unsigned core) override;
+	void optimize(const Task_name& name) override;
+	int scheduling_allowed(const Task_name& name) override;
+	void last_job_started(const Task_name& name) override;
+
+	// The sched-controller service has no call to remove a task.
+	bool withdraw(unsigned task_id, unsigned core) override;
+	void reset() override;
+
+protected:
+	Sched_controller::Connection _connection;
+};
+
+// Deterministic in-process controller.
+//
+// Modes: "accept-all" admits every task, "utilization" admits tasks while the utilization of a core stays within bound percent,
+// and "scripted" takes the verdicts from <verdict id="..." accept="yes|no" allowed="1"/> sub nodes, admitting and allowing unlisted tasks.
+// Every call is delayed by the latency-us attribute to emulate the cost of the real service.
+class Stub_controller : public Controller
+{
+public:
+	enum Mode { ACCEPT_ALL, UTILIZATION, SCRIPTED };
+
+	Stub_controller(const Genode::Xml_node& node, Mode mode);
+
+	void update_rq_buffer(unsigned core) override;
+	int new_task(const Rq_task::Rq_task& task, unsigned core) override;
+	void optimize(const Task_name& name) override;
+	int scheduling_allowed(const Task_name& name) override;
+	void last_job_started(const Task_name& name) override;
+	bool withdraw(unsigned task_id, unsigned core) override;
+	void reset() override;
+
+protected:
+	enum { MAX_VERDICTS = 64 };
+
+	struct Verdict
+	{
+		unsigned id;
+		bool accept;
+		int allowed;
+	};
+
+	const Mode _mode;
+	const unsigned _latency_us;
+	const unsigned _bound;
+	Timer::Connection _timer;
+
+	// Utilization of the accepted tasks by id, and their sum per core.
+	struct Accepted
+	{
+		unsigned core;
+		double utilization;
+	};
+	std::unordered_map<unsigned, Accepted> _accepted;
+	double _utilization[Core_placement::MAX_CORES];
+
+	Verdict _verdicts[MAX_VERDICTS];
+	unsigned _num_verdicts;
+
+	void _delay();
+
+	// Scripted verdict of the task, or nullptr.
+	const Verdict* _verdict(unsigned id) const;
+
+	// Task id from a task name of the form <id>.<binary>.
+	static unsigned _id(const Task_name& name);
+};
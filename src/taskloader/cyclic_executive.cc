@@ -0,0 +1,198 @@
+#include "cyclic_executive.h"
+
+#include <algorithm>
+
+#include <base/printf.h>
+
+Cyclic_executive::Cyclic_executive(Timer_wheel& wheel, const Release_config& config) :
+	_config(config),
+	_table{},
+	_hyperperiod{0},
+	_next{0},
+	_cycle_start{0},
+	_timeout{wheel, *this, &Cyclic_executive::_dispatch}
+{
+}
+
+bool Cyclic_executive::build(const std::vector<Task*>& tasks)
+{
+	clear();
+	if (tasks.empty())
+	{
+		return false;
+	}
+
+	// Hyperperiod and table size, bailing out as soon as the table gets too large.
+	unsigned long long hyperperiod = 1;
+	for (const Task* task : tasks)
+	{
+		const Task::Description& desc = task->desc();
+		if (desc.period == 0)
+		{
+			PWRN("Task %s has no period, not using a dispatch table.", task->name());
+			return false;
+		}
+		// The table repeats every hyperperiod, so it cannot hold the initial delay of an offset beyond the first period.
+		if (desc.offset >= desc.period)
+		{
+			PWRN("Offset of task %s is not within its first period, not using a dispatch table.", task->name());
+			return false;
+		}
+		if (desc.critical_time >= desc.period)
+		{
+			PWRN("Critical time of task %s reaches into its next period, not using a dispatch table.", task->name());
+			return false;
+		}
+		hyperperiod = hyperperiod / _gcd(hyperperiod, desc.period) * desc.period;
+		if (hyperperiod / desc.period > _config.max_table_entries)
+		{
+			PWRN("Hyperperiod too long for a dispatch table of %u entries.", _config.max_table_entries);
+			return false;
+		}
+	}
+
+	unsigned long long entries = 0;
+	for (const Task* task : tasks)
+	{
+		entries += hyperperiod / task->desc().period * (task->desc().critical_time > 0 ? 2 : 1);
+	}
+	if (entries > _config.max_table_entries)
+	{
+		PWRN("Dispatch table would need %llu entries, at most %u are allowed.", entries, _config.max_table_entries);
+		return false;
+	}
+
+	_hyperperiod = hyperperiod;
+	_table.reserve(entries);
+	for (Task* task : tasks)
+	{
+		const Task::Description& desc = task->desc();
+		for (unsigned long k = 0; k < _hyperperiod / desc.period; ++k)
+		{
+			const unsigned long release = desc.offset + k * desc.period;
+			_table.push_back(Entry{release % _hyperperiod, task, false});
+			if (desc.critical_time > 0)
+			{
+				_table.push_back(Entry{(release + desc.critical_time) % _hyperperiod, task, true});
+			}
+		}
+	}
+
+	// Kills before releases at the same time, so a killed instance makes room for the next one.
+	std::stable_sort(_table.begin(), _table.end(), [] (const Entry& a, const Entry& b)
+	{
+		return a.time < b.time || (a.time == b.time && a.kill && !b.kill);
+	});
+
+	PINF("Dispatch table of %u entries over a hyperperiod of %lu ms.", (unsigned)_table.size(), _hyperperiod);
+	return true;
+}
+
+void Cyclic_executive::start(unsigned long epoch)
+{
+	if (_table.empty())
+	{
+		return;
+	}
+	_next = 0;
+	_cycle_start = epoch;
+	_arm();
+}
+
+void Cyclic_executive::stop()
+{
+	_timeout.cancel();
+}
+
+void Cyclic_executive::forget(const Task* task)
+{
+	const bool armed = _timeout.armed();
+	_timeout.cancel();
+
+	const Entry* next = _next < _table.size() ? &_table[_next] : nullptr;
+	size_t next_index = 0;
+	size_t kept = 0;
+	for (size_t i = 0; i < _table.size(); ++i)
+	{
+		if (&_table[i] == next)
+		{
+			next_index = kept;
+		}
+		if (_table[i].task != task)
+		{
+			_table[kept++] = _table[i];
+		}
+	}
+	_table.resize(kept);
+
+	// All entries left in this hyperperiod are gone, continue with the first one of the next.
+	if (next_index < kept)
+	{
+		_next = next_index;
+	}
+	else
+	{
+		_next = 0;
+		_cycle_start += _hyperperiod;
+	}
+
+	if (armed && !_table.empty())
+	{
+		_arm();
+	}
+}
+
+void Cyclic_executive::clear()
+{
+	stop();
+	_table.clear();
+	_hyperperiod = 0;
+	_next = 0;
+}
+
+void Cyclic_executive::_dispatch()
+{
+	// All entries of this point in time.
+	const unsigned long time = _table[_next].time;
+	do
+	{
+		Entry& entry = _table[_next];
+		if (entry.task->table_driven())
+		{
+			if (entry.kill)
+			{
+				entry.task->kill_from_table();
+			}
+			else
+			{
+				entry.task->release_from_table();
+			}
+		}
+
+		if (++_next == _table.size())
+		{
+			_next = 0;
+			_cycle_start += _hyperperiod;
+			break;
+		}
+	}
+	while (_table[_next].time == time);
+
+	_arm();
+}
+
+void Cyclic_executive::_arm()
+{
+	_timeout.schedule(_cycle_start + _table[_next].time);
+}
+
+unsigned long long Cyclic_executive::_gcd(unsigned long long a, unsigned long long b)
+{
+	while (b != 0)
+	{
+		const unsigned long long r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
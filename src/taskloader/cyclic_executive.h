@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+
+#include <util/noncopyable.h>
+
+#include "task.h"
+#include "timer_wheel.h"
+
+// Table-driven dispatch of a periodic task set (<release dispatch="table"/>).
+// The releases and critical-time kills of all tasks over one hyperperiod are computed once and sorted into a table.
+// A single timeout walks the table cyclically, so each decision is a table lookup and the timer is only programmed once per distinct point in time.
+class Cyclic_executive : Genode::Noncopyable
+{
+public:
+	Cyclic_executive(Timer_wheel& wheel, const Release_config& config);
+
+	// Compute the table for tasks. Returns false if the set does not suit a table, e.g. a task has no period or the table would be too large.
+	bool build(const std::vector<Task*>& tasks);
+
+	// Walk the table from the epoch (see Timer_wheel::now()). The tasks must have been run table-driven with the same epoch.
+	void start(unsigned long epoch);
+	void stop();
+
+	// Drop all entries of a task, e.g. before it is destroyed.
+	void forget(const Task* task);
+
+	// Drop the table.
+	void clear();
+
+protected:
+	struct Entry
+	{
+		// Offset in the hyperperiod in ms.
+		unsigned long time;
+		Task* task;
+		bool kill;
+	};
+
+	const Release_config& _config;
+	std::vector<Entry> _table;
+	unsigned long _hyperperiod;
+
+	// Next entry and start of the current hyperperiod.
+	size_t _next;
+	unsigned long _cycle_start;
+
+	Timer_wheel::Member<Cyclic_executive> _timeout;
+
+	void _dispatch();
+	void _arm();
+
+	static unsigned long long _gcd(unsigned long long a, unsigned long long b);
+};
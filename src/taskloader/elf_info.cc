@@ -0,0 +1,66 @@
+#include "elf_info.h"
+
+#include <base/elf.h>
+#include <util/string.h>
+
+Elf_info::Elf_info() :
+	valid{false},
+	dynamic{false},
+	entry{0},
+	num_segments{0},
+	segments{}
+{
+}
+
+void Elf_info::parse(const char* image, size_t size)
+{
+	*this = Elf_info();
+
+	// Elf_binary reads the header without knowing the image size. 64 bytes hold the identification and header of both classes.
+	if (size < 64 || Genode::memcmp(image, "\177ELF", 4) != 0)
+	{
+		return;
+	}
+
+	Genode::Elf_binary elf((Genode::addr_t)image);
+	if (!elf.valid())
+	{
+		return;
+	}
+
+	for (unsigned i = 0; ; ++i)
+	{
+		Genode::Elf_segment segment = elf.get_segment(i);
+		if (!segment.valid())
+		{
+			break;
+		}
+		if (segment.file_offset() > size || segment.file_size() > size - segment.file_offset())
+		{
+			return;
+		}
+		if (num_segments < MAX_SEGMENTS)
+		{
+			const auto flags = segment.flags();
+			segments[num_segments] = {(Genode::addr_t)segment.start(), segment.file_offset(), segment.file_size(), segment.mem_size(), flags.w, flags.x};
+		}
+		++num_segments;
+	}
+
+	dynamic = elf.is_dynamically_linked();
+	entry = elf.entry();
+	valid = true;
+}
+
+size_t Elf_info::shared_size() const
+{
+	size_t shared = 0;
+	for (unsigned i = 0; i < num_segments && i < MAX_SEGMENTS; ++i)
+	{
+		if (!segments[i].writable)
+		{
+			shared += segments[i].file_size;
+		}
+	}
+	return shared;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <base/stdint.h>
+
+// Metadata of an ELF image, parsed once when a binary is sealed and shared by all instances started from it.
+// The image is read with Genode::Elf_binary, i.e., the same checks that apply when a child is started from it. Segments are additionally bounds-checked against the image size, so invalid uploads only yield valid == false.
+class Elf_info
+{
+public:
+	enum
+	{
+		MAX_SEGMENTS = 8
+	};
+
+	// Loadable (PT_LOAD) segment.
+	struct Segment
+	{
+		Genode::addr_t vaddr;
+		size_t offset;
+		size_t file_size;
+		size_t mem_size;
+		bool writable;
+		bool executable;
+	};
+
+	Elf_info();
+
+	// Parse the image. Resets everything first.
+	void parse(const char* image, size_t size);
+
+	bool valid;
+
+	// Needs the dynamic linker.
+	bool dynamic;
+	Genode::addr_t entry;
+
+	// num_segments may exceed MAX_SEGMENTS, segments beyond are not stored.
+	unsigned num_segments;
+	Segment segments[MAX_SEGMENTS];
+
+	// Bytes of read-only segments. These are attached from the stored binary by the loader and thus shared between all instances.
+	size_t shared_size() const;
+};
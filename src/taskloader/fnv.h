@@ -0,0 +1,30 @@
+#pragma once
+
+#include <base/stdint.h>
+#include <util/string.h>
+
+// 64 bit FNV-1a, used for hash tables and content fingerprints.
+namespace Fnv
+{
+	enum : Genode::uint64_t
+	{
+		OFFSET_BASIS = 14695981039346656037ull,
+		PRIME = 1099511628211ull
+	};
+
+	// Continue hash with size bytes at data.
+	inline Genode::uint64_t hash(const void* data, size_t size, Genode::uint64_t hash = OFFSET_BASIS)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (const unsigned char* c = bytes; c < bytes + size; ++c)
+		{
+			hash = (hash ^ *c) * PRIME;
+		}
+		return hash;
+	}
+
+	inline Genode::uint64_t hash(const char* str)
+	{
+		return hash(str, Genode::strlen(str));
+	}
+}
@@ -0,0 +1,46 @@
+#include "latency_histogram.h"
+
+#include <util/string.h>
+
+Latency_histogram::Latency_histogram() :
+	_data{}
+{
+}
+
+void Latency_histogram::add(Genode::uint64_t value)
+{
+	if (_data.count == 0 || value < _data.min)
+	{
+		_data.min = value;
+	}
+	if (value > _data.max)
+	{
+		_data.max = value;
+	}
+	_data.total += value;
+	++_data.count;
+
+	if (value >> Timing_snapshot::MAX_BITS)
+	{
+		++_data.overflow;
+	}
+	else
+	{
+		++_data.buckets[Timing_snapshot::bucket(value)];
+	}
+}
+
+void Latency_histogram::reset()
+{
+	Genode::memset(&_data, 0, sizeof(_data));
+}
+
+const Timing_snapshot::Histogram& Latency_histogram::data() const
+{
+	return _data;
+}
+
+Genode::uint64_t Latency_histogram::mean() const
+{
+	return _data.count > 0 ? _data.total / _data.count : 0;
+}
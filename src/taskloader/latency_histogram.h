@@ -0,0 +1,22 @@
+#pragma once
+
+#include <taskloader/timing_snapshot.h>
+
+// Fixed-size log-linear histogram of us values, see taskloader/timing_snapshot.h. Recording is O(1) and never allocates.
+// Not thread-safe, Task guards its histograms with Task::Shared_data::log_lock.
+class Latency_histogram
+{
+public:
+	Latency_histogram();
+
+	void add(Genode::uint64_t value);
+	void reset();
+
+	const Timing_snapshot::Histogram& data() const;
+
+	// Average of all values, 0 if there are none.
+	Genode::uint64_t mean() const;
+
+protected:
+	Timing_snapshot::Histogram _data;
+};
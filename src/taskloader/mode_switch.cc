@@ -0,0 +1,121 @@
+#include "mode_switch.h"
+
+#include <base/printf.h>
+
+Mode_switch::Mode_switch(const Genode::Xml_node& config, Clock& clock) :
+	_enabled{config.has_sub_node("mixed-criticality")},
+	_lo_policy{_lo_policy_from_config(config)},
+	_clock(clock),
+	_lock{},
+	_hi{false},
+	_hi_jobs{0},
+	_hi_since_us{0},
+	_hi_time_us{0},
+	_counts{},
+	_latency{}
+{
+}
+
+bool Mode_switch::enabled() const
+{
+	return _enabled;
+}
+
+Mode_switch::Lo_policy Mode_switch::lo_policy() const
+{
+	return _lo_policy;
+}
+
+bool Mode_switch::hi() const
+{
+	return _hi;
+}
+
+void Mode_switch::enter_hi(unsigned long long trigger_us, const char* task_name)
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+	Genode::Lock::Guard guard(_lock);
+	if (_hi)
+	{
+		return;
+	}
+	_hi = true;
+
+	const unsigned long long now_us = _clock.now_us();
+	_hi_since_us = now_us;
+	++_counts.hi_switches;
+	_latency.add(now_us > trigger_us ? now_us - trigger_us : 0);
+	PWRN("Switching to HI mode, triggered by %s.", task_name);
+}
+
+void Mode_switch::hi_job_started()
+{
+	Genode::Lock::Guard guard(_lock);
+	++_hi_jobs;
+}
+
+void Mode_switch::hi_job_finished()
+{
+	Genode::Lock::Guard guard(_lock);
+	if (_hi_jobs > 0)
+	{
+		--_hi_jobs;
+	}
+	if (!_hi || _hi_jobs > 0)
+	{
+		return;
+	}
+
+	_hi = false;
+	_hi_time_us += _clock.now_us() - _hi_since_us;
+	++_counts.lo_switches;
+	PINF("Switching back to LO mode.");
+}
+
+void Mode_switch::lo_release_dropped(bool degraded)
+{
+	Genode::Lock::Guard guard(_lock);
+	if (degraded)
+	{
+		++_counts.lo_degraded;
+	}
+	else
+	{
+		++_counts.lo_dropped;
+	}
+}
+
+void Mode_switch::counts(Timing_snapshot::Mode_counts& counts)
+{
+	Genode::Lock::Guard guard(_lock);
+	counts = _counts;
+	counts.hi = _hi;
+	counts.hi_time = _hi_time_us + (_hi ? _clock.now_us() - _hi_since_us : 0);
+	counts.switch_latency = _latency.data();
+}
+
+Mode_switch::Lo_policy Mode_switch::_lo_policy_from_config(const Genode::Xml_node& config)
+{
+	if (!config.has_sub_node("mixed-criticality"))
+	{
+		return LO_SUSPEND;
+	}
+	const Genode::Xml_node node = config.sub_node("mixed-criticality");
+	if (node.has_attribute("lo-tasks"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("lo-tasks");
+		if (attr.has_value("degrade"))
+		{
+			return LO_DEGRADE;
+		}
+		if (!attr.has_value("suspend"))
+		{
+			PWRN("Unknown policy for low-criticality tasks, suspending them in HI mode.");
+		}
+	}
+	return LO_SUSPEND;
+}
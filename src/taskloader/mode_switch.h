@@ -0,0 +1,68 @@
+#pragma once
+
+#include <base/lock.h>
+#include <util/noncopyable.h>
+#include <util/xml_node.h>
+#include <taskloader/timing_snapshot.h>
+
+#include "clock.h"
+#include "latency_histogram.h"
+
+// Criticality mode of the task set, enabled by the <mixed-criticality> config node.
+//
+// High-criticality tasks (fixed priority) run in both modes, low-criticality tasks (deadline, priority 128) only in LO mode.
+// A deadline miss or budget overrun of a high-criticality task switches to HI mode, in which releases of low-criticality tasks are dropped or degraded.
+// The switch only sets the mode, which every release checks, so it takes constant time regardless of the size of the task set.
+// The system returns to LO mode at the next idle instant, when no high-criticality job is left.
+// Mode changes may be requested from child threads, releases check the mode on the entrypoint.
+class Mode_switch : Genode::Noncopyable
+{
+public:
+	// What happens to releases of low-criticality tasks in HI mode ("lo-tasks").
+	enum Lo_policy
+	{
+		// Drop them ("suspend").
+		LO_SUSPEND,
+		// Start the fallback binary of the task instead, drop them if there is none ("degrade").
+		LO_DEGRADE
+	};
+
+	Mode_switch(const Genode::Xml_node& config, Clock& clock);
+
+	bool enabled() const;
+	Lo_policy lo_policy() const;
+
+	// Whether the system is in HI mode.
+	bool hi() const;
+
+	// Switch to HI mode for a miss or overrun that happened at trigger_us (see Clock). The switch latency is measured from there.
+	void enter_hi(unsigned long long trigger_us, const char* task_name);
+
+	// Track running high-criticality jobs. The last one to finish in HI mode switches back to LO mode.
+	void hi_job_started();
+	void hi_job_finished();
+
+	// Account a release of a low-criticality task in HI mode.
+	void lo_release_dropped(bool degraded);
+
+	// Copy the counters.
+	void counts(Timing_snapshot::Mode_counts& counts);
+
+protected:
+	const bool _enabled;
+	const Lo_policy _lo_policy;
+	Clock& _clock;
+
+	Genode::Lock _lock;
+	volatile bool _hi;
+	unsigned _hi_jobs;
+
+	// Time the current HI mode was entered and the time spent in HI mode before, in us.
+	unsigned long long _hi_since_us;
+	unsigned long long _hi_time_us;
+
+	Timing_snapshot::Mode_counts _counts;
+	Latency_histogram _latency;
+
+	static Lo_policy _lo_policy_from_config(const Genode::Xml_node& config);
+};
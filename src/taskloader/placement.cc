@@ -0,0 +1,149 @@
+#include "placement.h"
+
+#include <base/env.h>
+#include <base/printf.h>
+
+Core_placement::Core_placement(const Genode::Xml_node& config) :
+	_strategy{FIRST_FIT},
+	_first_core{1},
+	_num_cores{0},
+	_space{Genode::env()->cpu_session()->affinity_space()},
+	_utilization{}
+{
+	_num_cores = _space.width();
+	if (config.has_sub_node("placement"))
+	{
+		const Genode::Xml_node node = config.sub_node("placement");
+		_strategy = _strategy_from_config(node);
+		_first_core = node.attribute_value<unsigned>("first-core", _first_core);
+		_num_cores = node.attribute_value<unsigned>("cores", _num_cores);
+	}
+
+	if (_num_cores > MAX_CORES)
+	{
+		PWRN("Only using %u of %u cores.", (unsigned)MAX_CORES, _num_cores);
+		_num_cores = MAX_CORES;
+	}
+	if (_first_core >= _num_cores)
+	{
+		_first_core = _num_cores > 0 ? _num_cores - 1 : 0;
+	}
+	PINF("Placing tasks on cores %u to %u.", _first_core, _num_cores > 0 ? _num_cores - 1 : 0);
+}
+
+unsigned Core_placement::candidates(double utilization, unsigned* order) const
+{
+	unsigned num = 0;
+	for (unsigned core = _first_core; core < _num_cores; ++core)
+	{
+		order[num++] = core;
+	}
+
+	if (_strategy == FIRST_FIT)
+	{
+		return num;
+	}
+
+	// Insertion sort by utilization, stable so ties keep the lower core first.
+	for (unsigned i = 1; i < num; ++i)
+	{
+		const unsigned core = order[i];
+		unsigned j = i;
+		while (j > 0)
+		{
+			const double prev = _utilization[order[j - 1]];
+			const bool before = _strategy == WORST_FIT ? _utilization[core] < prev : _utilization[core] > prev;
+			if (!before)
+			{
+				break;
+			}
+			order[j] = order[j - 1];
+			--j;
+		}
+		order[j] = core;
+	}
+
+	if (_strategy == BEST_FIT)
+	{
+		// Move cores the task does not fit on to the back, the controller may still accept it there.
+		unsigned fitting = 0;
+		for (unsigned i = 0; i < num; ++i)
+		{
+			if (_utilization[order[i]] + utilization <= 1.0)
+			{
+				const unsigned core = order[i];
+				for (unsigned j = i; j > fitting; --j)
+				{
+					order[j] = order[j - 1];
+				}
+				order[fitting++] = core;
+			}
+		}
+	}
+	return num;
+}
+
+void Core_placement::assign(unsigned core, double utilization)
+{
+	if (core < _num_cores)
+	{
+		_utilization[core] += utilization;
+	}
+}
+
+void Core_placement::release(unsigned core, double utilization)
+{
+	if (core < _num_cores)
+	{
+		_utilization[core] = _utilization[core] > utilization ? _utilization[core] - utilization : 0.0;
+	}
+}
+
+void Core_placement::reset()
+{
+	for (double& utilization : _utilization)
+	{
+		utilization = 0.0;
+	}
+}
+
+unsigned Core_placement::first_core() const
+{
+	return _first_core;
+}
+
+unsigned Core_placement::num_cores() const
+{
+	return _num_cores;
+}
+
+double Core_placement::utilization(unsigned core) const
+{
+	return core < _num_cores ? _utilization[core] : 0.0;
+}
+
+Genode::Affinity Core_placement::affinity(unsigned core) const
+{
+	return Genode::Affinity(_space, Genode::Affinity::Location(core, 0, 1, 1));
+}
+
+Core_placement::Strategy Core_placement::_strategy_from_config(const Genode::Xml_node& node)
+{
+	if (node.has_attribute("strategy"))
+	{
+		const Genode::Xml_node::Attribute strategy = node.attribute("strategy");
+		if (strategy.has_value("worst-fit"))
+		{
+			return WORST_FIT;
+		}
+		if (strategy.has_value("best-fit"))
+		{
+			return BEST_FIT;
+		}
+		if (!strategy.has_value("first-fit"))
+		{
+			PWRN("Unknown placement strategy, using first-fit.");
+		}
+	}
+	return FIRST_FIT;
+}
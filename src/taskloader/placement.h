@@ -0,0 +1,52 @@
+#pragma once
+
+#include <base/affinity.h>
+#include <util/xml_node.h>
+
+// Chooses the order in which cores are offered to the controller for admitting a task, and tracks the utilization of accepted tasks per core.
+class Core_placement
+{
+public:
+	enum { MAX_CORES = 32 };
+
+	enum Strategy
+	{
+		// Lowest core index first ("first-fit").
+		FIRST_FIT,
+		// Least utilized core first ("worst-fit").
+		WORST_FIT,
+		// Most utilized core that still fits first ("best-fit").
+		BEST_FIT
+	};
+
+	// Reads the <placement> config node: strategy, first-core and cores (defaults to the width of our affinity space).
+	Core_placement(const Genode::Xml_node& config);
+
+	// Write the cores on which admission should be tried for a task with the given utilization into order. Returns the number of cores written.
+	unsigned candidates(double utilization, unsigned* order) const;
+
+	// Account a task accepted on core.
+	void assign(unsigned core, double utilization);
+
+	// Undo assign() for a task leaving core.
+	void release(unsigned core, double utilization);
+
+	// Forget all accounted tasks.
+	void reset();
+
+	unsigned first_core() const;
+	unsigned num_cores() const;
+	double utilization(unsigned core) const;
+
+	// Affinity for a CPU session of a task placed on core.
+	Genode::Affinity affinity(unsigned core) const;
+
+protected:
+	Strategy _strategy;
+	unsigned _first_core;
+	unsigned _num_cores;
+	Genode::Affinity::Space _space;
+	double _utilization[MAX_CORES];
+
+	static Strategy _strategy_from_config(const Genode::Xml_node& node);
+};
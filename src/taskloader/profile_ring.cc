@@ -0,0 +1,60 @@
+#include "profile_ring.h"
+
+#include <base/env.h>
+
+Profile_ring::Profile_ring(size_t capacity) :
+	_capacity{_round_capacity(capacity)},
+	_ds{Genode::env()->ram_session(), sizeof(Profile_log::Header) + _capacity * sizeof(Profile_log::Record)},
+	_header{*_ds.local_addr<Profile_log::Header>()},
+	_records{reinterpret_cast<Profile_log::Record*>(_ds.local_addr<char>() + sizeof(Profile_log::Header))},
+	_reserved{0}
+{
+	_header.write_pos = 0;
+	_header.read_pos = 0;
+	_header.dropped = 0;
+	_header.capacity = _capacity;
+	_header.record_size = sizeof(Profile_log::Record);
+}
+
+bool Profile_ring::reserve(size_t num)
+{
+	// Acquire pairs with the client's release store, so its reads of the freed slots are complete before we overwrite them.
+	const Genode::uint64_t read_pos = __atomic_load_n(&_header.read_pos, __ATOMIC_ACQUIRE);
+	const Genode::uint64_t used = _header.write_pos - read_pos;
+
+	if (used > _capacity || num > _capacity - used)
+	{
+		__atomic_store_n(&_header.dropped, _header.dropped + 1, __ATOMIC_RELAXED);
+		_reserved = 0;
+		return false;
+	}
+	_reserved = num;
+	return true;
+}
+
+Profile_log::Record& Profile_ring::record(size_t i)
+{
+	return _records[(_header.write_pos + i) & (_capacity - 1)];
+}
+
+void Profile_ring::commit()
+{
+	// Release makes the record contents visible before the new write position.
+	__atomic_store_n(&_header.write_pos, _header.write_pos + _reserved, __ATOMIC_RELEASE);
+	_reserved = 0;
+}
+
+Genode::Ram_dataspace_capability Profile_ring::cap() const
+{
+	return _ds.cap();
+}
+
+Genode::uint64_t Profile_ring::_round_capacity(size_t capacity)
+{
+	Genode::uint64_t out = 1;
+	while (out < capacity)
+	{
+		out <<= 1;
+	}
+	return out;
+}
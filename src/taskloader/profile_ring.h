@@ -0,0 +1,36 @@
+#pragma once
+
+#include <os/attached_ram_dataspace.h>
+#include <util/noncopyable.h>
+#include <taskloader/profile_log.h>
+
+// Fixed-capacity ring of profiling records in a dataspace shared with the client.
+// There must only be one writer at a time (Task::Shared_data::log_lock), the client reads without locking.
+class Profile_ring : Genode::Noncopyable
+{
+public:
+	// Capacity is rounded up to the next power of two.
+	Profile_ring(size_t capacity);
+
+	// Reserve space for num records. Returns false and counts the event as dropped if the client has not drained enough records yet.
+	bool reserve(size_t num);
+
+	// Record i of the current reservation.
+	Profile_log::Record& record(size_t i);
+
+	// Make the current reservation visible to the client.
+	void commit();
+
+	Genode::Ram_dataspace_capability cap() const;
+
+protected:
+	const Genode::uint64_t _capacity;
+	Genode::Attached_ram_dataspace _ds;
+	Profile_log::Header& _header;
+	Profile_log::Record* const _records;
+
+	// Number of records reserved but not yet committed.
+	size_t _reserved;
+
+	static Genode::uint64_t _round_capacity(size_t capacity);
+};
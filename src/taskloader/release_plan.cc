@@ -0,0 +1,132 @@
+#include "release_plan.h"
+
+#include <base/printf.h>
+
+Release_config::Release_config(const Genode::Xml_node& config) :
+	permission{PERMIT_LAZY},
+	prefork{false},
+	lead{10},
+	dispatch{DISPATCH_TASK},
+	max_table_entries{4096},
+	budget{BUDGET_WALL_CLOCK},
+	budget_interval{1},
+	budget_action{BUDGET_KILL}
+{
+	if (!config.has_sub_node("release"))
+	{
+		return;
+	}
+	const Genode::Xml_node node = config.sub_node("release");
+	prefork = node.attribute_value<bool>("prefork", prefork);
+	lead = node.attribute_value<unsigned>("lead", lead);
+	max_table_entries = node.attribute_value<unsigned>("max-entries", max_table_entries);
+	budget_interval = node.attribute_value<unsigned>("budget-interval", budget_interval);
+	if (budget_interval == 0)
+	{
+		budget_interval = 1;
+	}
+
+	if (node.has_attribute("dispatch"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("dispatch");
+		if (attr.has_value("table"))
+		{
+			dispatch = DISPATCH_TABLE;
+		}
+		else if (!attr.has_value("task"))
+		{
+			PWRN("Unknown release dispatch mode, using per-task timeouts.");
+		}
+	}
+
+	if (node.has_attribute("budget"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("budget");
+		if (attr.has_value("cpu"))
+		{
+			budget = BUDGET_CPU;
+		}
+		else if (!attr.has_value("wall-clock"))
+		{
+			PWRN("Unknown budget enforcement, using the critical time.");
+		}
+	}
+
+	if (node.has_attribute("budget-action"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("budget-action");
+		if (attr.has_value("flag"))
+		{
+			budget_action = BUDGET_FLAG;
+		}
+		else if (!attr.has_value("kill"))
+		{
+			PWRN("Unknown budget action, killing jobs over budget.");
+		}
+	}
+
+	if (node.has_attribute("permission"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("permission");
+		if (attr.has_value("batched"))
+		{
+			permission = PERMIT_BATCHED;
+		}
+		else if (!attr.has_value("lazy"))
+		{
+			PWRN("Unknown release permission mode, asking lazily.");
+		}
+	}
+}
+
+
+
+Release_plan::Release_plan() :
+	_epoch{0},
+	_offset{0},
+	_period{0},
+	_number_of_jobs{0},
+	_next_job{1},
+	_cancelled{true}
+{
+}
+
+void Release_plan::reset(unsigned long epoch_ms, unsigned offset_ms, unsigned period_ms, unsigned number_of_jobs)
+{
+	_epoch = epoch_ms;
+	_offset = offset_ms;
+	_period = period_ms;
+	_number_of_jobs = number_of_jobs;
+	_next_job = 1;
+	_cancelled = false;
+}
+
+void Release_plan::cancel()
+{
+	_cancelled = true;
+}
+
+bool Release_plan::pending() const
+{
+	return !_cancelled && (_number_of_jobs == 0 || _next_job <= _number_of_jobs);
+}
+
+unsigned Release_plan::next_job() const
+{
+	return _next_job;
+}
+
+unsigned long Release_plan::next_release() const
+{
+	return _epoch + _offset + (unsigned long)(_next_job - 1) * _period;
+}
+
+bool Release_plan::last() const
+{
+	return _number_of_jobs > 0 && _next_job == _number_of_jobs;
+}
+
+void Release_plan::advance()
+{
+	++_next_job;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <util/xml_node.h>
+
+// Global release options, read from the <release> config node.
+struct Release_config
+{
+	// When deadline tasks ask the controller for permission to start a job.
+	enum Permission
+	{
+		// Right before each release ("lazy").
+		PERMIT_LAZY,
+		// Once for all jobs when the task is started ("batched").
+		PERMIT_BATCHED
+	};
+
+	Release_config(const Genode::Xml_node& config);
+
+	Permission permission;
+
+	// Create the sessions of the next instance of a task as soon as the previous one is destroyed, instead of on release ("prefork").
+	bool prefork;
+
+	// Time in ms between starting a task set and its release epoch ("lead"), so all tasks are set up before the first release.
+	unsigned lead;
+
+	// How releases and kills of a task set are driven ("dispatch").
+	enum Dispatch
+	{
+		// Each task arms its own timeouts ("task").
+		DISPATCH_TASK,
+		// One precomputed table over the hyperperiod, see Cyclic_executive ("table").
+		DISPATCH_TABLE
+	};
+	Dispatch dispatch;
+
+	// Largest table for DISPATCH_TABLE ("max-entries"). Larger task sets fall back to DISPATCH_TASK.
+	unsigned max_table_entries;
+
+	// What ends a job that runs too long ("budget").
+	enum Budget
+	{
+		// Wall-clock time since the start reaching the critical time ("wall-clock").
+		BUDGET_WALL_CLOCK,
+		// CPU time of the child, sampled from its trace subjects, exceeding the execution time ("cpu").
+		// Tasks without an execution time keep the critical time.
+		BUDGET_CPU
+	};
+	Budget budget;
+
+	// Sampling interval in ms for BUDGET_CPU ("budget-interval").
+	unsigned budget_interval;
+
+	// What happens to a job that exceeds its CPU budget ("budget-action").
+	enum Budget_action
+	{
+		// Kill it like on the critical time ("kill").
+		BUDGET_KILL,
+		// Only count and report it ("flag").
+		BUDGET_FLAG
+	};
+	Budget_action budget_action;
+};
+
+// Release schedule of a task. Job n (starting at 1) is released at epoch + offset + (n - 1) * period ms.
+// All releases are computed from the epoch, so they do not drift with handling delays.
+class Release_plan
+{
+public:
+	Release_plan();
+
+	// Start a new schedule. number_of_jobs 0 means unbounded.
+	void reset(unsigned long epoch_ms, unsigned offset_ms, unsigned period_ms, unsigned number_of_jobs);
+
+	// Drop all remaining releases.
+	void cancel();
+
+	// Whether there are jobs left to release.
+	bool pending() const;
+
+	// Number of the next job to release.
+	unsigned next_job() const;
+
+	// Absolute release time of the next job in ms.
+	unsigned long next_release() const;
+
+	// Whether the next job is the last one of a bounded schedule.
+	bool last() const;
+
+	// Move on to the following job.
+	void advance();
+
+protected:
+	unsigned long _epoch;
+	unsigned _offset;
+	unsigned _period;
+	unsigned _number_of_jobs;
+	unsigned _next_job;
+	bool _cancelled;
+};
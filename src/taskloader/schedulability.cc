@@ -0,0 +1,208 @@
+#include "schedulability.h"
+
+#include <algorithm>
+
+#include "fnv.h"
+
+Schedulability_analysis::Schedulability_analysis(const Genode::Xml_node& config) :
+	_local{true},
+	_cache_enabled{true},
+	_admitted{},
+	_admitted_fingerprint{0},
+	_cache{}
+{
+	if (config.has_sub_node("analysis"))
+	{
+		const Genode::Xml_node node = config.sub_node("analysis");
+		_local = node.attribute_value<bool>("local", _local);
+		_cache_enabled = node.attribute_value<bool>("cache", _cache_enabled);
+	}
+}
+
+bool Schedulability_analysis::local() const
+{
+	return _local;
+}
+
+bool Schedulability_analysis::fits(unsigned core, const Rq_task::Rq_task& task) const
+{
+	if (!_local || core >= Core_placement::MAX_CORES)
+	{
+		return true;
+	}
+
+	std::vector<Rq_task::Rq_task> tasks{_admitted[core]};
+	tasks.push_back(task);
+
+	// Fixed-priority tasks always preempt deadline tasks, which only get the remaining capacity.
+	double fp_utilization = 0.0;
+	for (const Rq_task::Rq_task& t : tasks)
+	{
+		if (_fixed_priority(t) && t.inter_arrival > 0)
+		{
+			fp_utilization += (double)t.wcet / t.inter_arrival;
+		}
+	}
+	return response_time_test(tasks) && density_test(tasks, 1.0 - fp_utilization);
+}
+
+void Schedulability_analysis::add(unsigned core, const Rq_task::Rq_task& task)
+{
+	if (core < Core_placement::MAX_CORES)
+	{
+		_admitted[core].push_back(task);
+	}
+	_admitted_fingerprint += _hash(task);
+}
+
+void Schedulability_analysis::remove(unsigned core, const Rq_task::Rq_task& task)
+{
+	if (core >= Core_placement::MAX_CORES)
+	{
+		_admitted_fingerprint -= _hash(task);
+		return;
+	}
+
+	std::vector<Rq_task::Rq_task>& admitted = _admitted[core];
+	for (auto it = admitted.begin(); it != admitted.end(); ++it)
+	{
+		if (it->task_id == task.task_id)
+		{
+			_admitted_fingerprint -= _hash(*it);
+			admitted.erase(it);
+			return;
+		}
+	}
+}
+
+void Schedulability_analysis::reset()
+{
+	for (std::vector<Rq_task::Rq_task>& tasks : _admitted)
+	{
+		tasks.clear();
+	}
+	_admitted_fingerprint = 0;
+}
+
+Genode::uint64_t Schedulability_analysis::fingerprint(const std::vector<Rq_task::Rq_task>& tasks) const
+{
+	// Sum of hashes is independent of order. Mix in the admitted set so verdicts are only reused for the same starting point.
+	Genode::uint64_t set = 0;
+	for (const Rq_task::Rq_task& task : tasks)
+	{
+		set += _hash(task);
+	}
+	return set ^ (_admitted_fingerprint * 0x9e3779b97f4a7c15ull);
+}
+
+const std::vector<Schedulability_analysis::Verdict>* Schedulability_analysis::cached(Genode::uint64_t fingerprint) const
+{
+	if (!_cache_enabled)
+	{
+		return nullptr;
+	}
+	auto it = _cache.find(fingerprint);
+	return it != _cache.end() ? &it->second : nullptr;
+}
+
+void Schedulability_analysis::store(Genode::uint64_t fingerprint, const std::vector<Verdict>& verdicts)
+{
+	if (_cache_enabled)
+	{
+		_cache[fingerprint] = verdicts;
+	}
+}
+
+bool Schedulability_analysis::response_time_test(const std::vector<Rq_task::Rq_task>& tasks)
+{
+	// Order by the priority the children actually run with: the CPU session gets -priority, so lower values preempt higher ones.
+	// Equal priorities are ordered rate-monotonically, tasks without period are released once and sorted last among them.
+	std::vector<const Rq_task::Rq_task*> fp;
+	for (const Rq_task::Rq_task& task : tasks)
+	{
+		if (_fixed_priority(task))
+		{
+			fp.push_back(&task);
+		}
+	}
+	std::stable_sort(fp.begin(), fp.end(), [] (const Rq_task::Rq_task* a, const Rq_task::Rq_task* b)
+	{
+		if (a->prio != b->prio)
+		{
+			return a->prio < b->prio;
+		}
+		const unsigned long long period_a = a->inter_arrival > 0 ? a->inter_arrival : ~0ull;
+		const unsigned long long period_b = b->inter_arrival > 0 ? b->inter_arrival : ~0ull;
+		return period_a < period_b;
+	});
+
+	for (size_t i = 0; i < fp.size(); ++i)
+	{
+		const unsigned long long deadline = fp[i]->deadline > 0 ? fp[i]->deadline : fp[i]->inter_arrival;
+		if (deadline == 0)
+		{
+			continue;
+		}
+
+		unsigned long long response = fp[i]->wcet;
+		unsigned long long previous = 0;
+		while (response != previous && response <= deadline)
+		{
+			previous = response;
+			response = fp[i]->wcet;
+			for (size_t j = 0; j < i; ++j)
+			{
+				const unsigned long long period = fp[j]->inter_arrival;
+				const unsigned long long releases = period > 0 ? (previous + period - 1) / period : 1;
+				response += releases * fp[j]->wcet;
+			}
+		}
+		if (response > deadline)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Schedulability_analysis::density_test(const std::vector<Rq_task::Rq_task>& tasks, double capacity)
+{
+	double density = 0.0;
+	for (const Rq_task::Rq_task& task : tasks)
+	{
+		if (_fixed_priority(task))
+		{
+			continue;
+		}
+		unsigned long long interval = task.inter_arrival;
+		if (task.deadline > 0 && (interval == 0 || task.deadline < interval))
+		{
+			interval = task.deadline;
+		}
+		if (interval > 0)
+		{
+			density += (double)task.wcet / interval;
+		}
+	}
+	return density <= capacity;
+}
+
+Genode::uint64_t Schedulability_analysis::_hash(const Rq_task::Rq_task& task)
+{
+	const unsigned long long fields[] =
+	{
+		(unsigned long long)task.task_id,
+		(unsigned long long)task.wcet,
+		(unsigned long long)task.prio,
+		(unsigned long long)task.inter_arrival,
+		(unsigned long long)task.deadline,
+		(unsigned long long)task.task_class
+	};
+
+	return Fnv::hash(fields, sizeof(fields));
+}
+
+bool Schedulability_analysis::_fixed_priority(const Rq_task::Rq_task& task)
+{
+	return task.task_strategy == Rq_task::Task_strategy::priority;
+}
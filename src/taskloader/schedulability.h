@@ -0,0 +1,66 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <base/stdint.h>
+#include <util/xml_node.h>
+#include "sched_controller_session/connection.h"
+
+#include "placement.h"
+
+// In-process schedulability analysis over Rq_task parameters, used to pre-screen tasks before asking the controller.
+// Fixed-priority tasks are checked with a response time test under their assigned priorities.
+// Deadline tasks are checked with the EDF density test against the capacity left by the fixed-priority tasks.
+class Schedulability_analysis
+{
+public:
+	// Controller verdict for a single task of a task set.
+	struct Verdict
+	{
+		int task_id;
+		bool accepted;
+		unsigned core;
+	};
+
+	// Reads the <analysis> config node: local (pre-screen tasks) and cache (reuse verdicts of identical task sets).
+	Schedulability_analysis(const Genode::Xml_node& config);
+
+	bool local() const;
+
+	// Whether the core stays schedulable if task is added. Always true if local analysis is disabled.
+	bool fits(unsigned core, const Rq_task::Rq_task& task) const;
+
+	// Account a task admitted on core.
+	void add(unsigned core, const Rq_task::Rq_task& task);
+
+	// Undo add() for the task with the id of task.
+	void remove(unsigned core, const Rq_task::Rq_task& task);
+
+	// Forget all admitted tasks.
+	void reset();
+
+	// Key for the verdicts of adding tasks to the currently admitted set. Independent of task order.
+	Genode::uint64_t fingerprint(const std::vector<Rq_task::Rq_task>& tasks) const;
+
+	// Previously stored verdicts for the fingerprint or nullptr.
+	const std::vector<Verdict>* cached(Genode::uint64_t fingerprint) const;
+	void store(Genode::uint64_t fingerprint, const std::vector<Verdict>& verdicts);
+
+	static bool response_time_test(const std::vector<Rq_task::Rq_task>& tasks);
+	static bool density_test(const std::vector<Rq_task::Rq_task>& tasks, double capacity);
+
+protected:
+	bool _local;
+	bool _cache_enabled;
+
+	std::vector<Rq_task::Rq_task> _admitted[Core_placement::MAX_CORES];
+
+	// Order-independent combination of the hashes of all admitted tasks.
+	Genode::uint64_t _admitted_fingerprint;
+
+	std::unordered_map<Genode::uint64_t, std::vector<Verdict>> _cache;
+
+	static Genode::uint64_t _hash(const Rq_task::Rq_task& task);
+	static bool _fixed_priority(const Rq_task::Rq_task& task);
+};
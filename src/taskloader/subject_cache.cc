@@ -0,0 +1,155 @@
+#include "subject_cache.h"
+
+#include <base/printf.h>
+
+#include "task.h"
+
+Subject_cache::Subject_cache(Sampling sampling) :
+	_sampling{sampling},
+	_entries{},
+	_num_entries{0}
+{
+}
+
+void Subject_cache::refresh(Genode::Trace::Connection& trace)
+{
+	Genode::Trace::Subject_id ids[MAX_SUBJECTS];
+	const size_t num_ids = trace.subjects(ids, MAX_SUBJECTS);
+
+	// Drop subjects that were reported as vanished by the previous event.
+	size_t kept = 0;
+	for (size_t i = 0; i < _num_entries; ++i)
+	{
+		if (!_entries[i].vanished)
+		{
+			_entries[kept++] = _entries[i];
+		}
+	}
+	_num_entries = kept;
+
+	// Mark everything as vanished until it is found in the new subject list.
+	for (Entry& entry : *this)
+	{
+		entry.appeared = false;
+		entry.vanished = true;
+	}
+
+	// Look up known subjects and append new ones unsorted. The known range stays sorted during the loop.
+	const size_t num_known = _num_entries;
+	for (const Genode::Trace::Subject_id* id = ids; id < ids + num_ids; ++id)
+	{
+		size_t lo = 0;
+		size_t hi = num_known;
+		while (lo < hi)
+		{
+			const size_t mid = (lo + hi) / 2;
+			if (_entries[mid].id.id < id->id)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		if (lo < num_known && _entries[lo].id.id == id->id)
+		{
+			_entries[lo].vanished = false;
+			continue;
+		}
+
+		if (_num_entries == MAX_SUBJECTS)
+		{
+			// Vanished entries may still occupy the table. They are dropped next time.
+			continue;
+		}
+		Entry* entry = &_entries[_num_entries++];
+		*entry = Entry();
+		entry->id = *id;
+		entry->task = nullptr;
+		entry->appeared = true;
+	}
+
+	_sort();
+}
+
+void Subject_cache::flush()
+{
+	_num_entries = 0;
+}
+
+void Subject_cache::forget(const Task* task)
+{
+	for (Entry* entry = begin(); entry != end(); ++entry)
+	{
+		if (entry->task == task)
+		{
+			entry->task = nullptr;
+		}
+	}
+}
+
+bool Subject_cache::selects(const Entry& entry, int task_id) const
+{
+	switch (_sampling)
+	{
+		case SAMPLE_ALL:
+			return !entry.vanished;
+		case SAMPLE_CHANGED:
+			if (entry.appeared || entry.vanished)
+			{
+				return true;
+			}
+			// Fall through.
+		case SAMPLE_TASK:
+		default:
+			return entry.manager || (entry.task && (int)entry.task->desc().id == task_id);
+	}
+}
+
+Subject_cache::Entry* Subject_cache::begin()
+{
+	return _entries;
+}
+
+Subject_cache::Entry* Subject_cache::end()
+{
+	return _entries + _num_entries;
+}
+
+Subject_cache::Sampling Subject_cache::sampling_from_config(const Genode::Xml_node& trace_node)
+{
+	if (trace_node.has_attribute("sampling"))
+	{
+		const Genode::Xml_node::Attribute sampling = trace_node.attribute("sampling");
+		if (sampling.has_value("changed"))
+		{
+			return SAMPLE_CHANGED;
+		}
+		if (sampling.has_value("task"))
+		{
+			return SAMPLE_TASK;
+		}
+		if (!sampling.has_value("all"))
+		{
+			PWRN("Unknown trace sampling policy, sampling all subjects.");
+		}
+	}
+	return SAMPLE_ALL;
+}
+
+void Subject_cache::_sort()
+{
+	// Insertion sort. The table is sorted except for the few entries appended by refresh().
+	for (size_t i = 1; i < _num_entries; ++i)
+	{
+		const Entry entry = _entries[i];
+		size_t j = i;
+		while (j > 0 && _entries[j - 1].id.id > entry.id.id)
+		{
+			_entries[j] = _entries[j - 1];
+			--j;
+		}
+		_entries[j] = entry;
+	}
+}
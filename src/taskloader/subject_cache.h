@@ -0,0 +1,79 @@
+#pragma once
+
+#include <trace_session/connection.h>
+#include <util/noncopyable.h>
+#include <taskloader/profile_log.h>
+
+class Task;
+
+// Table of trace subjects, sorted by subject id.
+// Labels and task association of a subject never change, so they are only queried once when the subject appears.
+class Subject_cache : Genode::Noncopyable
+{
+public:
+	enum { MAX_SUBJECTS = 128 };
+
+	// Which subjects are sampled for an event, configured by the sampling attribute of the <trace> config node.
+	enum Sampling
+	{
+		// All live subjects ("all").
+		SAMPLE_ALL,
+		// Subjects that appeared or vanished since the last event, plus the triggering task and the task manager ("changed").
+		SAMPLE_CHANGED,
+		// Only the triggering task and the task manager ("task").
+		SAMPLE_TASK
+	};
+
+	struct Entry
+	{
+		Genode::Trace::Subject_id id;
+
+		char session[Profile_log::SESSION_LEN];
+		char thread[Profile_log::THREAD_LEN];
+
+		// Managed task running in this subject, or nullptr. Resolved once on appearance.
+		Task* task;
+
+		// Subject is a thread of the task manager itself.
+		bool manager;
+
+		// Last sampled values.
+		Genode::Trace::CPU_info::State state;
+		unsigned long long execution_time;
+
+		// Subject appeared during the last refresh and still needs its labels resolved.
+		bool appeared;
+
+		// Subject was missing during the last refresh. Dropped on the next one.
+		bool vanished;
+
+		// Selected for the current event.
+		bool sampled;
+	};
+
+	Subject_cache(Sampling sampling);
+
+	// Query the subject list once and merge it into the table.
+	void refresh(Genode::Trace::Connection& trace);
+
+	// Forget all subjects, e.g. because the tasks they refer to are destroyed.
+	void flush();
+
+	// Drop the association of all subjects with task, e.g. because it is destroyed.
+	void forget(const Task* task);
+
+	// Whether the entry should be sampled for an event triggered by task_id.
+	bool selects(const Entry& entry, int task_id) const;
+
+	Entry* begin();
+	Entry* end();
+
+	static Sampling sampling_from_config(const Genode::Xml_node& trace_node);
+
+protected:
+	const Sampling _sampling;
+	Entry _entries[MAX_SUBJECTS];
+	size_t _num_entries;
+
+	void _sort();
+};
@@ -1,3 +1,3 @@
 TARGET = taskloader
-SRC_CC = main.cc task.cc taskloader_session_component.cc
+SRC_CC = main.cc arena.cc binary_store.cc clock.cc controller.cc cyclic_executive.cc elf_info.cc latency_histogram.cc mode_switch.cc placement.cc release_plan.cc schedulability.cc task.cc taskloader_session_component.cc timer_wheel.cc profile_ring.cc subject_cache.cc wcet_estimator.cc
 LIBS = base config libc stdcxx server
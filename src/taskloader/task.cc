@@ -1,29 +1,32 @@
 #include "task.h"
 
 #include <cstring>
-#include <vector>
 
-#include <base/elf.h>
 #include <base/lock.h>
+#include <util/string.h>
+
+#include "fnv.h"
 
 Task::Child_policy::Child_policy(Task& task) :
 		_task{&task},
-		_labeling_policy{task.name().c_str()},
+		_labeling_policy{task.name()},
 		_config_policy{"config", task._config.cap(), &task._child_ep},
-		_binary_policy{"binary", task._shared.binaries.at(task._desc.binary_name).cap(), &task._child_ep},
+		_binary_policy{"binary", task._binary->ds.cap(), &task._child_ep},
 		_active{true}
 {
 }
 
 void Task::Child_policy::exit(int exit_value)
 {
-	Genode::Lock::Guard guard(_exit_lock);
-	// Already exited, waiting for destruction.
-	if (!_active)
 	{
-		return;
+		Genode::Lock::Guard guard(_exit_lock);
+		// Already exited, waiting for destruction.
+		if (!_active)
+		{
+			return;
+		}
+		_active = false;
 	}
-	_active = false;
 	PDBG("child %s exited with exit value %d", name(), exit_value);
 
 	Task::Event::Type type;
@@ -39,14 +42,17 @@ void Task::Child_policy::exit(int exit_value)
 			type = Event::EXIT_ERROR;
 	}
 
-	Task::log_profile_data(type, _task->_desc.id, _task->_shared);
+	Task* task = _task;
+	Task::log_profile_data(type, task->_desc.id, task->_shared);
+	task->_record_exit(type);
 
-	//Task::_child_destructor.submit_for_destruction(_task);
+	// This policy may be destroyed as soon as the task is submitted. Do not touch any members afterwards.
+	Task::_child_destructor.submit_for_destruction(task);
 }
 
 const char* Task::Child_policy::name() const
 {
-	return _task->name().c_str();
+	return _task->name();
 }
 
 bool Task::Child_policy::active() const
@@ -104,7 +110,7 @@ bool Task::Child_policy::announce_service(
 		return false;
 	}
 
-	_task->_shared.child_services.insert(new (alloc) Genode::Child_service(service_name, root, &_task->_meta->server));
+	_task->_shared.child_services.insert(new (alloc) Genode::Child_service(service_name, root, &_task->_meta->meta.server));
 	PINF("%s registered service %s\n", name(), service_name);
 
 	return true;
@@ -113,7 +119,7 @@ bool Task::Child_policy::announce_service(
 void Task::Child_policy::unregister_services()
 {
 	Genode::Service *rs;
-	while ((rs = _task->_shared.child_services.find_by_server(&_task->_meta->server)))
+	while ((rs = _task->_shared.child_services.find_by_server(&_task->_meta->meta.server)))
 	{
 		_task->_shared.child_services.remove(rs);
 	}
@@ -123,7 +129,7 @@ void Task::Child_policy::unregister_services()
 
 Task::Meta::Meta(const Task& task) :
 	ram{},
-	cpu{task.name().c_str(), -(long int)task._desc.priority, (long int)task._desc.deadline, Genode::Affinity(Genode::Affinity::Space(2,1),Genode::Affinity::Location(2,0))},
+	cpu{task.name(), -(long int)task._desc.priority, (long int)task._desc.deadline, task._shared.placement.affinity(task._desc.core)},
 	rm{},
 	pd{},
 	server{ram}
@@ -131,16 +137,16 @@ Task::Meta::Meta(const Task& task) :
 	ram.ref_account(Genode::env()->ram_session_cap());
 	if (Genode::env()->ram_session()->transfer_quota(ram.cap(), task._desc.quota) != 0)
 	{
-		PWRN("Failed to transfer RAM quota to child %s", task.name().c_str());
+		PWRN("Failed to transfer RAM quota to child %s", task.name());
 	}
 }
 
 
 
-Task::Meta_ex::Meta_ex(Task& task) :
-		Meta{task},
+Task::Meta_ex::Meta_ex(Task& task, Meta& meta) :
+		meta(meta),
 		policy{task},
-		child{task._shared.binaries.at(task._desc.binary_name).cap(), pd.cap(), ram.cap(), cpu.cap(), rm.cap(), &task._child_ep, &policy}
+		child{task._binary->ds.cap(), meta.pd.cap(), meta.ram.cap(), meta.cpu.cap(), meta.rm.cap(), &task._child_ep, &policy}
 {
 }
 
@@ -156,56 +162,324 @@ const char* Task::Event::type_name(Type type)
 		case EXIT_ERROR: return "EXIT_ERROR";
 		case EXIT_EXTERNAL: return "EXIT_EXTERNAL";
 		case EXTERNAL: return "EXTERNAL";
+		case DEADLINE_MISS: return "DEADLINE_MISS";
 		default: return "UNKNOWN";
 	}
 }
 
 
 
-Task::Shared_data::Shared_data(size_t trace_quota, size_t trace_buf_size) :
-	binaries{},
+Task::Shared_data::Shared_data(Server::Entrypoint& ep, const Genode::Xml_node& config, size_t trace_quota, size_t trace_buf_size, size_t profile_records, Subject_cache::Sampling sampling) :
+	binaries{config},
 	heap{Genode::env()->ram_session(), Genode::env()->rm_session()},
 	parent_services{},
-	trace{trace_quota, trace_buf_size, 0}
+	trace{trace_quota, trace_buf_size, 0},
+	subjects{sampling},
+	profile{profile_records},
+	timer{},
+	clock{timer},
+	wheel{ep},
+	arena{config},
+	tasks{Arena_allocator<Task>(arena)},
+	release{config},
+	estimator{config},
+	mode{config, clock},
+	placement{config},
+	tasks_added{0},
+	bytes_uploaded{0},
+	estimate_handler{nullptr}
+{
+}
+
+void Task::Shared_data::record_cost(Timing_snapshot::Operation op, unsigned long long start_us)
+{
+	const unsigned long long end_us = clock.now_us();
+	Genode::Lock::Guard guard(log_lock);
+	operation_costs[op].add(end_us - start_us);
+}
+
+
+
+void Task::Shared_data::index_task(Task_list::iterator task)
+{
+	Genode::Lock::Guard guard(log_lock);
+
+	if (!tasks_by_id.emplace(task->_desc.id, task).second)
+	{
+		PWRN("Duplicate task id %u, lookups by id will return the first task.", task->_desc.id);
+	}
+	tasks_by_name.emplace(Name_key{task->_name.string(), Genode::strlen(task->_name.string())}, &*task);
+}
+
+void Task::Shared_data::unindex_task(Task& task)
+{
+	Genode::Lock::Guard guard(log_lock);
+
+	auto by_id = tasks_by_id.find(task._desc.id);
+	if (by_id != tasks_by_id.end() && &*by_id->second == &task)
+	{
+		tasks_by_id.erase(by_id);
+	}
+	auto by_name = tasks_by_name.find(Name_key{task._name.string(), Genode::strlen(task._name.string())});
+	if (by_name != tasks_by_name.end() && by_name->second == &task)
+	{
+		tasks_by_name.erase(by_name);
+	}
+	subjects.forget(&task);
+}
+
+void Task::Shared_data::clear_index()
+{
+	Genode::Lock::Guard guard(log_lock);
+	tasks_by_name.clear();
+	tasks_by_id.clear();
+}
+
+size_t Task::Shared_data::Name_hash::operator()(const Name_key& key) const
+{
+	return Fnv::hash(key.str, key.len);
+}
+
+bool Task::Shared_data::Name_equal::operator()(const Name_key& a, const Name_key& b) const
 {
+	return a.len == b.len && Genode::memcmp(a.str, b.str, a.len) == 0;
 }
 
 
 
-Task::Task(Server::Entrypoint& ep, Genode::Cap_connection& cap, Shared_data& shared, const Genode::Xml_node& node, Sched_controller::Connection* ctrl) :
+Task::Task(Server::Entrypoint& ep, Genode::Cap_connection& cap, Shared_data& shared, const Description& desc, const char* config, size_t config_size, Controller* ctrl) :
 		_shared(shared),
-		_desc{
-			_get_node_value<unsigned int>(node, "id"),
-			_get_node_value<unsigned int>(node, "executiontime"),
-			_get_node_value<unsigned int>(node, "criticaltime"),
-			_get_node_value<unsigned int>(node, "priority"),
-			_get_node_value<unsigned int>(node, "deadline"),
-			_get_node_value<unsigned int>(node, "period"),
-			_get_node_value<unsigned int>(node, "offset"),
-			_get_node_value<unsigned int>(node, "numberofjobs"),
-			_get_node_value<Genode::Number_of_bytes>(node, "quota"),
-			_get_node_value(node, "pkg", 32, "")},
-		_config{Genode::env()->ram_session(), node.sub_node("config").size()},
+		_desc(desc),
+		_config{Genode::env()->ram_session(), config_size},
 		_name{_make_name()},
 		_iteration{0},
 		_paused{true},
-		_start_timer{},
-		_kill_timer{},
-		_start_dispatcher{ep, *this, &Task::_start},
-		_kill_dispatcher{ep, *this, &Task::_kill_crit},
-		_idle_dispatcher{ep, *this, &Task::_idle},
-		_child_ep{&cap, 12 * 1024, _name.c_str(), false},
+		_plan{},
+		_batch_permission{0},
+		_table_driven{false},
+		_release_timeout{shared.wheel, *this, &Task::_release},
+		_kill_timeout{shared.wheel, *this, &Task::_kill_crit},
+		_budget_timeout{shared.wheel, *this, &Task::_check_budget},
+		_child_ep{&cap, 12 * 1024, _name.string(), false},
 		_meta{nullptr},
+		_prepared{nullptr},
+		_binary{nullptr},
+		_destroyed_dispatcher{ep, *this, &Task::_child_destroyed},
+		_release_us{0},
+		_release_latency{},
+		_response_time{},
+		_start_jitter{},
+		_deadlines{},
+		_overruns{},
+		_cpu_time{},
+		_budget{},
+		_specified_execution_time{desc.execution_time},
+		_estimated_jobs{0},
+		_pending{},
+		_first_pending{0},
+		_num_pending{0},
+		_degraded{false},
+		_jobs{0},
+		_last_start_us{0},
+		_last_start_job{0},
 		_controller(ctrl),
 		_schedulable(true)
 {
-	const Genode::Xml_node& config_node = node.sub_node("config");
-	std::strncpy(_config.local_addr<char>(), config_node.addr(), config_node.size());
-	PINF("id: %u, name: %s, prio: %u, deadline: %u, wcet: %u, period: %u", _desc.id, _name.c_str(), _desc.priority, _desc.deadline, _desc.execution_time, _desc.period);
+	_desc.core = shared.placement.first_core();
+
+	// Keep the binaries while the task is loaded, not only while an instance runs.
+	shared.binaries.pin(_desc.binary_name);
+	if (*_desc.fallback_binary)
+	{
+		shared.binaries.pin(_desc.fallback_binary);
+	}
+
+	Genode::memcpy(_config.local_addr<char>(), config, config_size);
+	PINF("id: %u, name: %s, prio: %u, deadline: %u, wcet: %u, period: %u", _desc.id, _name.string(), _desc.priority, _desc.deadline, _desc.execution_time, _desc.period);
+}
+
+void Task::parse_description(const Genode::Xml_node& node, Description& desc, const char*& config, size_t& config_size)
+{
+	static const char* const EMPTY_CONFIG = "<config/>";
+
+	desc = Description();
+	config = EMPTY_CONFIG;
+	config_size = Genode::strlen(EMPTY_CONFIG);
+
+	const auto fn = [&desc, &config, &config_size] (const Genode::Xml_node& field)
+	{
+		if (field.has_type("id"))
+		{
+			field.value(&desc.id);
+		}
+		else if (field.has_type("executiontime"))
+		{
+			field.value(&desc.execution_time);
+		}
+		else if (field.has_type("criticaltime"))
+		{
+			field.value(&desc.critical_time);
+		}
+		else if (field.has_type("priority"))
+		{
+			field.value(&desc.priority);
+		}
+		else if (field.has_type("deadline"))
+		{
+			field.value(&desc.deadline);
+		}
+		else if (field.has_type("period"))
+		{
+			field.value(&desc.period);
+		}
+		else if (field.has_type("offset"))
+		{
+			field.value(&desc.offset);
+		}
+		else if (field.has_type("numberofjobs"))
+		{
+			field.value(&desc.number_of_jobs);
+		}
+		else if (field.has_type("quota"))
+		{
+			field.value(&desc.quota);
+		}
+		else if (field.has_type("pkg"))
+		{
+			field.value(desc.binary_name, sizeof(desc.binary_name));
+		}
+		else if (field.has_type("config"))
+		{
+			config = field.addr();
+			config_size = field.size();
+		}
+		else if (field.has_type("overrun"))
+		{
+			_parse_overrun(field, desc);
+		}
+	};
+	node.for_each_sub_node(fn);
+}
+
+void Task::_parse_overrun(const Genode::Xml_node& node, Description& desc)
+{
+	if (node.has_attribute("policy"))
+	{
+		const Genode::Xml_node::Attribute attr = node.attribute("policy");
+		if (attr.has_value("queue"))
+		{
+			desc.overrun = Description::OVERRUN_QUEUE;
+		}
+		else if (attr.has_value("kill"))
+		{
+			desc.overrun = Description::OVERRUN_KILL;
+		}
+		else if (attr.has_value("degrade"))
+		{
+			desc.overrun = Description::OVERRUN_DEGRADE;
+		}
+		else if (!attr.has_value("skip"))
+		{
+			PWRN("Unknown overrun policy, skipping overrun releases.");
+		}
+	}
+
+	desc.max_queued = node.attribute_value<unsigned>("queue", 1);
+	if (node.has_attribute("fallback"))
+	{
+		node.attribute("fallback").value(desc.fallback_binary, sizeof(desc.fallback_binary));
+	}
+	_check_overrun(desc);
+}
+
+void Task::_check_overrun(Description& desc)
+{
+	if (desc.max_queued > MAX_QUEUED)
+	{
+		PWRN("At most %u overrun releases can be queued.", (unsigned)MAX_QUEUED);
+		desc.max_queued = MAX_QUEUED;
+	}
+	if (desc.overrun == Description::OVERRUN_DEGRADE && desc.fallback_binary[0] == '\0')
+	{
+		PWRN("Degrading overrun policy without fallback binary, skipping overrun releases.");
+		desc.overrun = Description::OVERRUN_SKIP;
+	}
+}
+
+bool Task::parse_description(const Task_descriptor::Record& record, Description& desc)
+{
+	// Package names must be terminated within the record.
+	if (!_terminated(record.pkg, sizeof(record.pkg)) || !_terminated(record.fallback_pkg, sizeof(record.fallback_pkg)) || record.overrun > Description::OVERRUN_DEGRADE)
+	{
+		return false;
+	}
+
+	desc = Description();
+	desc.id = record.id;
+	desc.execution_time = record.execution_time;
+	desc.critical_time = record.critical_time;
+	desc.priority = record.priority;
+	desc.deadline = record.deadline;
+	desc.period = record.period;
+	desc.offset = record.offset;
+	desc.number_of_jobs = record.number_of_jobs;
+	desc.quota = record.quota;
+	Genode::strncpy(desc.binary_name, record.pkg, sizeof(desc.binary_name));
+	desc.overrun = (Description::Overrun)record.overrun;
+	desc.max_queued = record.max_queued;
+	Genode::strncpy(desc.fallback_binary, record.fallback_pkg, sizeof(desc.fallback_binary));
+	_check_overrun(desc);
+	return true;
+}
+
+bool Task::_terminated(const char* str, size_t size)
+{
+	for (const char* c = str; c < str + size; ++c)
+	{
+		if (*c == '\0')
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 Task::~Task()
 {
+	_shared.binaries.unpin(_desc.binary_name);
+	if (*_desc.fallback_binary)
+	{
+		_shared.binaries.unpin(_desc.fallback_binary);
+	}
+
+	if (_prepared)
+	{
+		Genode::destroy(_shared.heap, _prepared);
+	}
+}
+
+void Task::timing(Timing_snapshot::Task_entry& entry) const
+{
+	entry.task_id = _desc.id;
+	entry.jobs = _jobs;
+	entry.release_latency = _release_latency.data();
+	entry.response_time = _response_time.data();
+	entry.start_jitter = _start_jitter.data();
+	entry.deadlines = _deadlines;
+	entry.overruns = _overruns;
+	entry.cpu_time = _cpu_time.histogram().data();
+	entry.budget = _budget;
+	entry.wcet.average = _cpu_time.average();
+	entry.wcet.percentile = _cpu_time.percentile(_shared.estimator.percentile);
+	entry.wcet.specified = _specified_execution_time;
+	entry.wcet.admitted = _desc.execution_time;
+}
+
+double Task::miss_ratio() const
+{
+	const unsigned missed = _deadlines.late + _deadlines.killed + _deadlines.skipped;
+	const unsigned total = missed + _deadlines.on_time;
+	return total > 0 ? (double)missed / total : 0.0;
 }
 
 void Task::setSchedulable(bool schedulable)
@@ -218,6 +492,17 @@ bool Task::isSchedulable()
 	return _schedulable;
 }
 
+void Task::setCore(unsigned int core)
+{
+	_desc.core = core;
+}
+
+double Task::utilization() const
+{
+	const unsigned int interval = _desc.period > 0 ? _desc.period : _desc.deadline;
+	return interval > 0 ? (double)_desc.execution_time / interval : 0.0;
+}
+
 Rq_task::Rq_task Task::getRqTask()
 {
 	Rq_task::Rq_task rq_task;
@@ -226,7 +511,7 @@ Rq_task::Rq_task Task::getRqTask()
 	rq_task.prio = _desc.priority;
 	rq_task.inter_arrival = _desc.period;
 	rq_task.deadline = _desc.deadline;
-	strcpy(rq_task.name, _name.c_str());
+	strcpy(rq_task.name, _name.string());
 	
 	if((_desc.priority - 128) == 0)
 	{
@@ -243,76 +528,94 @@ Rq_task::Rq_task Task::getRqTask()
 }
 
 void Task::run()
+{
+	run(_shared.wheel.now() + _shared.release.lead);
+}
+
+void Task::run(unsigned long epoch, bool table_driven)
 {
 	_paused = false;
+	_table_driven = table_driven;
+	_last_start_us = 0;
+	_prepare();
 
-	// (Re-)Register timeout handlers.
-	_start_timer.sigh(_start_dispatcher);
-	_kill_timer.sigh(_kill_dispatcher);
+	// Tasks without period run once, at their offset.
+	_plan.reset(epoch, _desc.offset, _desc.period, _desc.period > 0 ? _desc.number_of_jobs : 1);
 
-	if (_desc.period > 0)
+	if (_desc.period > 0 && _desc.number_of_jobs > 0 && _deadline_task() && _shared.release.permission == Release_config::PERMIT_BATCHED)
 	{
-		if(_desc.number_of_jobs == 0)
-		{
-			_start_timer.trigger_periodic(_desc.period * 1000);
-		}
-		else
-		{
-			Genode::String<32> task_name(_name.c_str());
-			int starting_permission;
-			for(unsigned int i = 1; i <= _desc.number_of_jobs; ++i)
-			{
-				
-				// if task is edf task, query monitor, else start job
-				if((_desc.priority - 128) == 0)
-				{
-					PINF("Taskloader (task.run): Call optimizer due to job %d of task %s.", i, _name.c_str());
-					// perform optimization (call this function now, since optimizer is no individual thread)
-					_controller->optimize(task_name);
-				
-					// determine result of optimization
-					starting_permission = _controller->scheduling_allowed(task_name);
-					
-				}
-				else
-				{
-					starting_permission = 1;
-				}
-				if(starting_permission > 0)
-				{
-					_start_timer.trigger_once(_desc.period * 1000);
-					PINF("Taskloader (task.run): Start job %d of task %s.", i, _name.c_str());
-				}
-				if(starting_permission < 0)
-				{
-					PWRN("Taskloader (task.run): Task %s (job %d) is not recognized by optimizer.", _name.c_str(), i);
-					break;
-				}
-			}
-			if((starting_permission > 0) && ((_desc.priority - 128) == 0))
-			{
-				PINF("Taskloader (task.run): Last job (%d) of task %s started.", _desc.number_of_jobs, _name.c_str());
-				_controller->last_job_started(task_name);
-			}
-		}
+		Genode::String<32> task_name(_name.string());
+		PINF("Taskloader (task.run): Call optimizer once for all %u jobs of task %s.", _desc.number_of_jobs, _name.string());
+		_controller->optimize(task_name);
+		_batch_permission = _controller->scheduling_allowed(task_name);
 	}
-	else
+
+	_arm_release();
+}
+
+bool Task::table_driven() const
+{
+	return _table_driven;
+}
+
+void Task::release_from_table()
+{
+	_release();
+}
+
+void Task::kill_from_table()
+{
+	// The table has a kill slot for every release, most of them find the job already finished.
+	if (_meta && _meta->policy.active() && !_cpu_budget())
 	{
-		_start(0);
+		_kill_crit();
 	}
 }
 
 void Task::stop()
 {
-	PINF("Stopping task %s\n", _name.c_str());
+	PINF("Stopping task %s\n", _name.string());
+
+	// Copy the statistics, the child thread may still record its exit. Print without holding the lock.
+	Timing_snapshot::Histogram latency;
+	Genode::uint64_t latency_mean;
+	Timing_snapshot::Deadline_counts deadlines;
+	unsigned miss_percent;
+	Timing_snapshot::Budget_counts budget;
+	{
+		Genode::Lock::Guard guard(_shared.log_lock);
+		latency = _release_latency.data();
+		latency_mean = _release_latency.mean();
+		deadlines = _deadlines;
+		miss_percent = (unsigned)(miss_ratio() * 100);
+		budget = _budget;
+	}
+
+	if (latency.count > 0)
+	{
+		PINF("Release latency of %s over %u jobs: min %llu us, avg %llu us, max %llu us", _name.string(), latency.count, latency.min, latency_mean, latency.max);
+	}
+	if (_jobs > 0 || deadlines.skipped > 0)
+	{
+		PINF("Jobs of %s: %u on time, %u late, %u killed, %u skipped, miss ratio %u%%", _name.string(), deadlines.on_time, deadlines.late, deadlines.killed, deadlines.skipped, miss_percent);
+	}
+	if (budget.killed > 0 || budget.flagged > 0)
+	{
+		PINF("Jobs of %s over CPU budget: %u killed, %u flagged", _name.string(), budget.killed, budget.flagged);
+	}
 	_paused = true;
 	_stop_timers();
 	_kill(19);
 }
 
-std::string Task::name() const
+void Task::wait_for_teardown()
+{
+	_child_destructor.wait_for_destruction(*this);
+}
+
+const char* Task::name() const
 {
-	return _name;
+	return _name.string();
 }
 
 bool Task::running() const
@@ -320,83 +623,169 @@ bool Task::running() const
 	return _meta != nullptr;
 }
 
-const Task::Description& Task::desc() const
+bool Task::torn_down() const
 {
-	return _desc;
+	return _child_destructor.destroyed(*this);
 }
 
-Task* Task::task_by_name(std::list<Task>& tasks, const std::string& name)
+bool Task::active() const
 {
-	for (Task& task : tasks)
+	return !_paused;
+}
+
+void Task::update_timing(const Description& desc)
+{
+	// Prepared sessions carry the old priority, deadline and core.
+	if (_prepared)
 	{
-		if (task.name() == name)
-		{
-			return &task;
-		}
+		Genode::destroy(_shared.heap, _prepared);
+		_prepared = nullptr;
+	}
+
+	_desc.execution_time = desc.execution_time;
+	_desc.critical_time = desc.critical_time;
+	_desc.priority = desc.priority;
+	_desc.deadline = desc.deadline;
+	_desc.period = desc.period;
+	_desc.offset = desc.offset;
+	_desc.number_of_jobs = desc.number_of_jobs;
+	_specified_execution_time = desc.execution_time;
+	PINF("Updated %s: prio: %u, deadline: %u, wcet: %u, period: %u", _name.string(), _desc.priority, _desc.deadline, _desc.execution_time, _desc.period);
+}
+
+unsigned Task::due_estimate()
+{
+	if (!_shared.estimator.push)
+	{
+		return 0;
+	}
+
+	Genode::Lock::Guard guard(_shared.log_lock);
+	const unsigned jobs = _cpu_time.histogram().data().count;
+	if (jobs < _estimated_jobs + _shared.estimator.push_every)
+	{
+		return 0;
+	}
+	const unsigned estimate = _cpu_time.estimate(_shared.estimator);
+	if (estimate == 0)
+	{
+		return 0;
 	}
-	return nullptr;
+	_estimated_jobs = jobs;
+	return estimate < _specified_execution_time ? estimate : _specified_execution_time;
+}
+
+void Task::refine_execution_time(unsigned execution_time)
+{
+	Genode::Lock::Guard guard(_shared.log_lock);
+	_desc.execution_time = execution_time;
+}
+
+const Task::Description& Task::desc() const
+{
+	return _desc;
 }
 
-void Task::log_profile_data(Event::Type type, int task_id, Shared_data& shared)
+Task* Task::task_by_name(Shared_data& shared, const char* name, size_t len)
+{
+	auto it = shared.tasks_by_name.find(Shared_data::Name_key{name, len});
+	return it != shared.tasks_by_name.end() ? it->second : nullptr;
+}
+
+Task* Task::task_by_id(Shared_data& shared, unsigned int id)
+{
+	auto it = shared.tasks_by_id.find(id);
+	return it != shared.tasks_by_id.end() ? &*it->second : nullptr;
+}
+
+Task::Task_list::iterator Task::task_iterator(Shared_data& shared, unsigned int id)
+{
+	auto it = shared.tasks_by_id.find(id);
+	return it != shared.tasks_by_id.end() ? it->second : shared.tasks.end();
+}
+
+void Task::log_profile_data(Event::Type type, int task_id, Shared_data& shared, Profile_log::Deadline_miss miss)
 {
-	static const size_t MAX_NUM_SUBJECTS = 128;
 	// Lock to avoid race conditions as this may be called by the child's thread.
 	Genode::Lock::Guard guard(shared.log_lock);
+	const unsigned long long start_us = shared.clock.now_us();
+
+	// A single RPC to detect appeared and vanished subjects. Labels are only queried for new ones.
+	shared.subjects.refresh(shared.trace);
+
+	size_t num_infos = 0;
+	for (Subject_cache::Entry& entry : shared.subjects)
+	{
+		if (entry.appeared)
+		{
+			_resolve_subject(entry, shared);
+		}
+		entry.sampled = shared.subjects.selects(entry, task_id);
+		num_infos += entry.sampled ? 1 : 0;
+	}
 
-	Genode::Trace::Subject_id subjects[MAX_NUM_SUBJECTS];
-	const size_t num_subjects = shared.trace.subjects(subjects, MAX_NUM_SUBJECTS);
-	Genode::Trace::CPU_info info;
-	Genode::Trace::RAM_info ram_info;
+	// Drop the event as a whole if the client has not drained the log far enough.
+	if (!shared.profile.reserve(1 + num_infos))
+	{
+		return;
+	}
 
-	shared.event_log.emplace_back();
-	Event& event = shared.event_log.back();
+	Profile_log::Record& event_record = shared.profile.record(0);
+	event_record.kind = Profile_log::EVENT;
+	Profile_log::Event_record& event = event_record.event;
 
 	event.type = type;
 	event.task_id = task_id;
 	event.time_stamp = shared.timer.elapsed_ms();
+	event.num_infos = num_infos;
+	event.miss = type == Event::DEADLINE_MISS ? miss : 0;
 
-	Event::Task_info* task_manager_info = nullptr;
+	Profile_log::Task_info_record* task_manager_info = nullptr;
 
-	for (Genode::Trace::Subject_id* subject = subjects; subject < subjects + num_subjects; ++subject)
+	size_t i = 1;
+	for (Subject_cache::Entry& entry : shared.subjects)
 	{
-		info = shared.trace.cpu_info(*subject);
-		ram_info = shared.trace.ram_info(*subject);
-		event.task_infos.emplace_back();
-		Event::Task_info& task_info = event.task_infos.back();
-
-		task_info.id = subject->id;
-		task_info.session = ram_info.session_label().string(),
-		task_info.thread = ram_info.thread_name().string(),
-		task_info.state = info.state(),
-		task_info.execution_time = info.execution_time().value;
+		if (!entry.sampled)
+		{
+			continue;
+		}
 
-		// Check if the session is started by this task manager (i.e., a managed task).
-		size_t leaf_pos = task_info.session.rfind("task-manager -> ");
-		Task* task = nullptr;
-		if (leaf_pos < std::string::npos)
+		// Vanished subjects are reported with their last known values.
+		if (!entry.vanished)
 		{
-			const std::string process = task_info.session.substr(leaf_pos + 16);
-			if (process == task_info.thread)
-			{
-				task = task_by_name(shared.tasks, task_info.session.substr(leaf_pos + 16));
-			}
+			const Genode::Trace::CPU_info info = shared.trace.cpu_info(entry.id);
+			entry.state = info.state();
+			entry.execution_time = info.execution_time().value;
 		}
+
+		Profile_log::Record& record = shared.profile.record(i++);
+		record.kind = Profile_log::TASK_INFO;
+		Profile_log::Task_info_record& task_info = record.task_info;
+
+		task_info.id = entry.id.id;
+		task_info.state = entry.state;
+		task_info.execution_time = entry.execution_time;
+		task_info.managed = false;
+		Genode::memcpy(task_info.session, entry.session, sizeof(task_info.session));
+		Genode::memcpy(task_info.thread, entry.thread, sizeof(task_info.thread));
+
+		Task* task = entry.task;
 		if (task && task->running())
 		{
 			task_info.managed = true;
-			task_info.managed_info.id = task->_desc.id;
-			task_info.managed_info.quota = task->_meta->ram.quota();
-			task_info.managed_info.used = task->_meta->ram.used();
-			task_info.managed_info.iteration = task->_iteration;
+			task_info.managed_id = task->_desc.id;
+			task_info.managed_quota = task->_meta->meta.ram.quota();
+			task_info.managed_used = task->_meta->meta.ram.used();
+			task_info.managed_iteration = task->_iteration;
 		}
 		// Check if this is task-manager itself.
-		else if (task_info.session.rfind("task-manager") == task_info.session.length() - 12 && task_info.thread == "task-manager")
+		else if (entry.manager)
 		{
 			task_info.managed = true;
-			task_info.managed_info.id = 0;
-			task_info.managed_info.quota = Genode::env()->ram_session()->quota();
-			task_info.managed_info.used = Genode::env()->ram_session()->used();
-			task_info.managed_info.iteration = 0;
+			task_info.managed_id = 0;
+			task_info.managed_quota = Genode::env()->ram_session()->quota();
+			task_info.managed_used = Genode::env()->ram_session()->used();
+			task_info.managed_iteration = 0;
 
 			// Hack: there are two task-manager processes. We only flag the more active one as managed.
 			if (!task_manager_info)
@@ -409,16 +798,156 @@ void Task::log_profile_data(Event::Type type, int task_id, Shared_data& shared)
 			}
 		}
 	}
+
+	const unsigned long long cost = shared.clock.now_us() - start_us;
+	event.sample_cost = cost;
+	shared.operation_costs[Timing_snapshot::OP_LOG_EVENT].add(cost);
+	shared.profile.commit();
+}
+
+void Task::_resolve_subject(Subject_cache::Entry& entry, Shared_data& shared)
+{
+	static const char* const MANAGER_NAME = "task-manager";
+	static const char* const MANAGER_PREFIX = "task-manager -> ";
+
+	const Genode::Trace::RAM_info ram_info = shared.trace.ram_info(entry.id);
+	const char* session = ram_info.session_label().string();
+	const char* thread = ram_info.thread_name().string();
+
+	Genode::strncpy(entry.session, session, sizeof(entry.session));
+	Genode::strncpy(entry.thread, thread, sizeof(entry.thread));
+	entry.task = nullptr;
+	entry.manager = false;
+
+	// Check if the session is started by this task manager (i.e., a managed task).
+	const char* leaf = _find_last(session, MANAGER_PREFIX);
+	if (leaf)
+	{
+		const char* process = leaf + Genode::strlen(MANAGER_PREFIX);
+		if (Genode::strcmp(process, thread) == 0)
+		{
+			entry.task = task_by_name(shared, process, Genode::strlen(process));
+		}
+	}
+
+	// Check if this is task-manager itself.
+	const size_t session_len = Genode::strlen(session);
+	const size_t manager_len = Genode::strlen(MANAGER_NAME);
+	if (!entry.task && session_len >= manager_len && Genode::strcmp(session + session_len - manager_len, MANAGER_NAME) == 0 && Genode::strcmp(thread, MANAGER_NAME) == 0)
+	{
+		entry.manager = true;
+	}
 }
 
-std::string Task::_make_name() const
+Task::Name Task::_make_name() const
 {
 	char id[4];
 	snprintf(id, sizeof(id), "%.2d.", _desc.id);
-	return std::string(id) + _desc.binary_name;
+	char name[NAME_LEN];
+	snprintf(name, sizeof(name), "%s%s", id, _desc.binary_name);
+	return Name(name);
+}
+
+void Task::_release()
+{
+	if (_paused || !_plan.pending())
+	{
+		return;
+	}
+
+	const unsigned long long release_us = _shared.clock.now_us();
+	const unsigned job = _plan.next_job();
+	const bool last = _plan.last();
+	_plan.advance();
+
+	if (_shared.mode.hi() && !_high_criticality())
+	{
+		_arm_release();
+		_release_in_hi_mode(release_us, job);
+		return;
+	}
+
+	// Only the bounded job sequence of deadline tasks is supervised by the controller.
+	const int starting_permission = _desc.period > 0 && _desc.number_of_jobs > 0 ? _permission(job) : 1;
+	if (starting_permission < 0)
+	{
+		PWRN("Taskloader (task.run): Task %s (job %d) is not recognized by optimizer.", _name.string(), job);
+		_plan.cancel();
+		return;
+	}
+
+	// Arm the next release before starting, so child creation does not delay it.
+	_arm_release();
+
+	if (starting_permission > 0)
+	{
+		PINF("Taskloader (task.run): Start job %d of task %s.", job, _name.string());
+		_start(release_us, job);
+
+		if (last && _desc.number_of_jobs > 0 && _deadline_task())
+		{
+			PINF("Taskloader (task.run): Last job (%d) of task %s started.", _desc.number_of_jobs, _name.string());
+			_controller->last_job_started(Genode::String<32>(_name.string()));
+		}
+	}
+}
+
+void Task::_arm_release()
+{
+	if (_table_driven || !_plan.pending())
+	{
+		return;
+	}
+
+	_release_timeout.schedule(_plan.next_release());
+}
+
+int Task::_permission(unsigned job)
+{
+	if (!_deadline_task())
+	{
+		return 1;
+	}
+
+	if (_shared.release.permission == Release_config::PERMIT_BATCHED)
+	{
+		return _batch_permission;
+	}
+
+	Genode::String<32> task_name(_name.string());
+	PINF("Taskloader (task.run): Call optimizer due to job %d of task %s.", job, _name.string());
+	// perform optimization (call this function now, since optimizer is no individual thread)
+	_controller->optimize(task_name);
+
+	// determine result of optimization
+	return _controller->scheduling_allowed(task_name);
+}
+
+bool Task::_deadline_task() const
+{
+	return (_desc.priority - 128) == 0;
+}
+
+bool Task::_high_criticality() const
+{
+	return !_deadline_task();
 }
 
-void Task::_start(unsigned)
+void Task::_release_in_hi_mode(unsigned long long release_us, unsigned job)
+{
+	// Degraded releases bypass the controller like those of OVERRUN_DEGRADE.
+	const bool degrade = _shared.mode.lo_policy() == Mode_switch::LO_DEGRADE && *_desc.fallback_binary && !running();
+	_shared.mode.lo_release_dropped(degrade);
+	if (!degrade)
+	{
+		PINF("Dropping job %u of %s in HI mode.", job, _name.string());
+		return;
+	}
+	_degraded = true;
+	_start(release_us, job);
+}
+
+void Task::_start(unsigned long long release_us, unsigned job)
 {
 	if (_paused)
 	{
@@ -428,45 +957,74 @@ void Task::_start(unsigned)
 
 	if (running())
 	{
-		PINF("Trying to start %s but previous instance still running or undestroyed. Abort.\n", _name.c_str());
+		_overrun(release_us, job);
 		return;
 	}
 
-	// Check if binary has already been received.
-	auto bin_it = _shared.binaries.find(_desc.binary_name);
-	if (bin_it == _shared.binaries.end())
+	// A release that finds the previous instance gone ends degraded operation.
+	const char* binary_name = _degraded ? _desc.fallback_binary : _desc.binary_name;
+	_degraded = false;
+
+	// Check if binary has already been received. The instance holds a reference on it until it is destroyed.
+	_binary = _shared.binaries.acquire(binary_name);
+	if (!_binary)
 	{
-		PERR("Binary %s for task %s not found, possibly not yet received by dom0.", _desc.binary_name.c_str(), _name.c_str());
+		PERR("Binary %s for task %s not found, possibly not yet received by dom0.", binary_name, _name.string());
 		return;
 	}
 
-	Genode::Attached_ram_dataspace& ds = bin_it->second;
+	if (!_binary->elf.valid)
+	{
+		PERR("Binary %s for task %s is no valid ELF image.", binary_name, _name.string());
+		_release_binary();
+		return;
+	}
 
+	_release_us = release_us;
 	++_iteration;
-	PINF("Starting %s linked task %s with quota %u and priority %u in iteration %d", _check_dynamic_elf(ds) ? "dynamically" : "statically", _name.c_str(), (size_t)_desc.quota, _desc.priority, _iteration);
+	PINF("Starting %s linked task %s with quota %u and priority %u in iteration %d", _binary->elf.dynamic ? "dynamically" : "statically", _name.string(), (size_t)_desc.quota, _desc.priority, _iteration);
 
 	if ((size_t)_desc.quota < 512 * 1024)
 	{
-		PWRN("Warning: RAM quota for %s might be too low to hold meta data.", _name.c_str());
+		PWRN("Warning: RAM quota for %s might be too low to hold meta data.", _name.string());
 	}
 
-	// Dispatch kill timer after critical time.
-	if (_desc.critical_time > 0)
+	// Dispatch kill timer after critical time, or sample the CPU time against the budget.
+	if (_cpu_budget())
 	{
-		_kill_timer.trigger_once(_desc.critical_time * 1000);
+		_budget_timeout.schedule_in(_shared.release.budget_interval, _shared.release.budget_interval);
+	}
+	else if (_desc.critical_time > 0 && !_table_driven)
+	{
+		_kill_timeout.schedule_in(_desc.critical_time);
 	}
 
 	// Abort if RAM quota insufficient. Alternatively, we could give all remaining quota to the child.
-	if (_desc.quota > Genode::env()->ram_session()->avail()) {
-		PERR("Not enough RAM quota for task %s, requested: %u, available: %u", _name.c_str(), (size_t)_desc.quota, Genode::env()->ram_session()->avail());
+	if (!_prepared && _desc.quota > Genode::env()->ram_session()->avail()) {
+		PERR("Not enough RAM quota for task %s, requested: %u, available: %u", _name.string(), (size_t)_desc.quota, Genode::env()->ram_session()->avail());
+		_release_binary();
 		return;
 	}
 
+	// Count the job before the child can exit, undone below if it cannot be created.
+	const bool hi_job = _high_criticality();
+	if (hi_job)
+	{
+		_shared.mode.hi_job_started();
+	}
+
+	Meta* meta = _prepared;
+	_prepared = nullptr;
 	try
 	{
-		// Create child and activate entrypoint.
-		_meta = new (&_shared.heap) Meta_ex(*this);
+		// Create child and activate entrypoint. Only the child itself is created here if the sessions have been prepared.
+		if (!meta)
+		{
+			meta = new (&_shared.heap) Meta(*this);
+		}
+		_meta = new (&_shared.heap) Meta_ex(*this, *meta);
 		_child_ep.activate();
+		_record_start(job);
 	}
 	catch (Genode::Cpu_session::Thread_creation_failed)
 	{
@@ -477,48 +1035,312 @@ void Task::_start(unsigned)
 		PWRN("Failed to create child - unknown reason");
 	}
 
+	// Keep the sessions for the next attempt if the child could not be created.
+	if (!_meta)
+	{
+		_prepared = meta;
+		_release_binary();
+		if (hi_job)
+		{
+			_shared.mode.hi_job_finished();
+		}
+	}
+
 	log_profile_data(Event::START, _desc.id, _shared);
 }
 
 Task::Child_destructor_thread::Child_destructor_thread() :
 	Thread{"child_destructor"},
 	_lock{},
-	_queued{}
+	_queued{},
+	_waiters{},
+	_pending{0}
 {
 	start();
 }
 
 void Task::Child_destructor_thread::submit_for_destruction(Task* task)
+{
+	{
+		Genode::Lock::Guard guard(_lock);
+		_queued.push_back(task);
+	}
+	_pending.up();
+}
+
+void Task::Child_destructor_thread::wait_for_destruction(Task& task)
+{
+	Genode::Semaphore destroyed{0};
+	{
+		Genode::Lock::Guard guard(_lock);
+		if (!task._meta)
+		{
+			return;
+		}
+		_waiters.push_back(Waiter{&task, &destroyed});
+	}
+	destroyed.down();
+}
+
+bool Task::Child_destructor_thread::destroyed(const Task& task)
 {
 	Genode::Lock::Guard guard(_lock);
-	_queued.push_back(task);
+	return !task._meta;
 }
 
 void Task::Child_destructor_thread::entry()
 {
 	while (true)
 	{
-		_lock.lock();
-		for (Task* task : _queued)
+		_pending.down();
+
+		Genode::Lock::Guard guard(_lock);
+		Task* task = _queued.front();
+		_queued.pop_front();
+
+		PDBG("Destroying task %s", task->_name.string());
+		task->_destroy_meta();
+
+		// Counted here rather than on the coalescing teardown signal. May be the idle instant that ends HI mode.
+		if (task->_high_criticality())
+		{
+			task->_shared.mode.hi_job_finished();
+		}
+
+		// Let the entrypoint start a waiting release or prepare the next instance.
+		// Before waking waiters, as they may destroy the task right away. The task is not touched after that.
+		Genode::Signal_transmitter(task->_destroyed_dispatcher).submit();
+
+		for (auto it = _waiters.begin(); it != _waiters.end();)
 		{
-			PDBG("Destroying task %s", task->_name.c_str());
-			Genode::destroy(task->_shared.heap, task->_meta);
-			task->_meta = nullptr;
+			if (it->task == task)
+			{
+				it->destroyed->up();
+				it = _waiters.erase(it);
+			}
+			else
+			{
+				++it;
+			}
 		}
-		_queued.clear();
-		_lock.unlock();
-		_timer.msleep(10);
 	}
 }
 
 Task::Child_destructor_thread Task::_child_destructor;
 
-void Task::_kill_crit(unsigned)
+void Task::_prepare()
+{
+	if (!_shared.release.prefork || _prepared || running() || _paused)
+	{
+		return;
+	}
+
+	if (_desc.quota > Genode::env()->ram_session()->avail())
+	{
+		PWRN("Not enough RAM quota to prepare the next instance of %s.", _name.string());
+		return;
+	}
+
+	try
+	{
+		_prepared = new (&_shared.heap) Meta(*this);
+	}
+	catch (...)
+	{
+		PWRN("Failed to prepare sessions for %s", _name.string());
+	}
+}
+
+void Task::_destroy_meta()
+{
+	Meta& meta = _meta->meta;
+	Genode::destroy(_shared.heap, _meta);
+	Genode::destroy(_shared.heap, &meta);
+	_release_binary();
+	_meta = nullptr;
+}
+
+void Task::_release_binary()
+{
+	if (_binary)
+	{
+		_shared.binaries.release(_binary);
+		_binary = nullptr;
+	}
+}
+
+void Task::_record_start(unsigned job)
+{
+	const unsigned long long now = _shared.clock.now_us();
+
+	Genode::Lock::Guard guard(_shared.log_lock);
+	++_jobs;
+	_release_latency.add(now - _release_us);
+
+	// Jobs skipped in between stretch the expected interval.
+	if (_desc.period > 0 && _last_start_us > 0 && job > _last_start_job)
+	{
+		const unsigned long long expected = (unsigned long long)(job - _last_start_job) * _desc.period * 1000;
+		const unsigned long long interval = now - _last_start_us;
+		_start_jitter.add(interval > expected ? interval - expected : expected - interval);
+	}
+	_last_start_us = now;
+	_last_start_job = job;
+}
+
+void Task::_overrun(unsigned long long release_us, unsigned job)
+{
+	bool skip = true;
+	switch (_desc.overrun)
+	{
+		case Description::OVERRUN_QUEUE:
+			if (_num_pending < _desc.max_queued)
+			{
+				_pending[(_first_pending + _num_pending++) % MAX_QUEUED] = {release_us, job};
+				++_overruns.queued;
+				skip = false;
+			}
+			else
+			{
+				++_overruns.dropped;
+			}
+			break;
+
+		case Description::OVERRUN_KILL:
+			++_overruns.restarted;
+			_restart(release_us, job);
+			skip = false;
+			break;
+
+		case Description::OVERRUN_DEGRADE:
+			if (_desc.fallback_binary[0] != '\0')
+			{
+				++_overruns.degraded;
+				_degraded = true;
+				_restart(release_us, job);
+				skip = false;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	if (skip)
+	{
+		PINF("Trying to start %s but previous instance still running or undestroyed. Abort.\n", _name.string());
+		{
+			Genode::Lock::Guard guard(_shared.log_lock);
+			++_deadlines.skipped;
+		}
+		if (_high_criticality())
+		{
+			_shared.mode.enter_hi(release_us, _name.string());
+		}
+		log_profile_data(Event::DEADLINE_MISS, _desc.id, _shared, Profile_log::MISS_SKIPPED);
+	}
+}
+
+void Task::_restart(unsigned long long release_us, unsigned job)
+{
+	// Replace whatever is pending by this release and start it once the killed instance is destroyed.
+	_first_pending = 0;
+	_num_pending = 1;
+	_pending[0] = {release_us, job};
+	_kill(17);
+}
+
+void Task::_child_destroyed(unsigned)
+{
+	_budget_timeout.cancel();
+
+	// Start an overrun release that waited for the previous instance.
+	if (_num_pending > 0 && !_paused)
+	{
+		const Pending_release release = _pending[_first_pending];
+		_first_pending = (_first_pending + 1) % MAX_QUEUED;
+		--_num_pending;
+		_start(release.release_us, release.job);
+	}
+	_prepare();
+
+	// The CPU time of the finished job is recorded by now. Only this task is checked, at most every push-every jobs.
+	if (_shared.estimate_handler && !_paused && _schedulable)
+	{
+		const unsigned estimate = due_estimate();
+		if (estimate > 0 && estimate != _desc.execution_time)
+		{
+			_shared.estimate_handler->refine(*this, estimate);
+		}
+	}
+
+	if (_shared.teardown_sigh.valid())
+	{
+		Genode::Signal_transmitter(_shared.teardown_sigh).submit();
+	}
+}
+
+void Task::_record_exit(Event::Type type)
+{
+	Profile_log::Deadline_miss miss;
+	unsigned long long miss_us = 0;
+	{
+		Genode::Lock::Guard guard(_shared.log_lock);
+
+		// Sample again, the exit event skips sampling if the profile log is full.
+		// Only jobs that ran to completion describe the execution time, killed or crashed ones would bias the estimate.
+		unsigned long long consumed = 0;
+		if (type == Event::EXIT && _consumed_us(true, consumed))
+		{
+			_cpu_time.add(consumed);
+		}
+
+		switch (type)
+		{
+			case Event::EXIT:
+			{
+				const unsigned long long response = _shared.clock.now_us() - _release_us;
+				_response_time.add(response);
+				const unsigned deadline = _relative_deadline();
+				if (deadline == 0 || response <= (unsigned long long)deadline * 1000)
+				{
+					++_deadlines.on_time;
+					return;
+				}
+				++_deadlines.late;
+				miss = Profile_log::MISS_LATE;
+				miss_us = _release_us + (unsigned long long)deadline * 1000;
+				break;
+			}
+			case Event::EXIT_CRITICAL:
+			case Event::EXIT_ERROR:
+				++_deadlines.killed;
+				miss = Profile_log::MISS_KILLED;
+				miss_us = _shared.clock.now_us();
+				break;
+			default:
+				// Stopped from outside, no judgement on the job.
+				return;
+		}
+	}
+	if (_high_criticality())
+	{
+		_shared.mode.enter_hi(miss_us, _name.string());
+	}
+	log_profile_data(Event::DEADLINE_MISS, _desc.id, _shared, miss);
+}
+
+unsigned Task::_relative_deadline() const
+{
+	return _desc.deadline > 0 ? _desc.deadline : _desc.period;
+}
+
+void Task::_kill_crit()
 {
 	// Check for paused status for the rare case where timer signals have been triggered before stopping but are handled after.
 	if (!_paused)
 	{
-		PINF("Critical time reached for %s", _name.c_str());
+		PINF("Critical time reached for %s", _name.string());
 		_kill(17);
 	}
 }
@@ -528,50 +1350,106 @@ void Task::_kill(int exit_value)
 	// Task might have a valid _meta and be inactive for the short time between submitting the task for destruction and the actual destruction. In that case we do nothing.
 	if (_meta && _meta->policy.active())
 	{
-		PINF("Force-exiting %s", _name.c_str());
+		PINF("Force-exiting %s", _name.string());
 		// Child::exit() is usually called from the child thread. Use this carefully.
 		_meta->child.exit(exit_value);
 	}
 }
 
-void Task::_idle(unsigned)
+bool Task::_cpu_budget() const
 {
-	// Do nothing.
+	return _shared.release.budget == Release_config::BUDGET_CPU && _specified_execution_time > 0;
 }
 
-void Task::_stop_timers()
+void Task::_check_budget()
 {
-	// "Stop" timers. Apparently there is no way to stop a running timer, so instead we let it trigger an idle method.
-	_stop_kill_timer();
-	_stop_start_timer();
-}
+	if (_paused || !_meta || !_meta->policy.active())
+	{
+		_budget_timeout.cancel();
+		return;
+	}
 
-void Task::_stop_kill_timer()
-{
-	_kill_timer.sigh(_idle_dispatcher);
-	_kill_timer.trigger_once(0);
+	// A high-criticality job over its (LO mode) budget switches to HI mode and keeps running.
+	const bool overrun_hi = _shared.mode.enabled() && _high_criticality();
+	const bool flag = overrun_hi || _shared.release.budget_action == Release_config::BUDGET_FLAG;
+
+	const unsigned long long budget = (unsigned long long)_specified_execution_time * 1000;
+	unsigned long long consumed = 0;
+	{
+		Genode::Lock::Guard guard(_shared.log_lock);
+		// The subjects of a new instance are known from its start event.
+		if (!_consumed_us(true, consumed) || consumed <= budget)
+		{
+			return;
+		}
+
+		if (flag)
+		{
+			++_budget.flagged;
+		}
+		else
+		{
+			++_budget.killed;
+		}
+	}
+
+	// Once per job.
+	_budget_timeout.cancel();
+	if (overrun_hi)
+	{
+		_shared.mode.enter_hi(_shared.clock.now_us(), _name.string());
+	}
+	if (flag)
+	{
+		PWRN("Task %s exceeded its CPU budget of %u ms in iteration %d (%llu us used).", _name.string(), _specified_execution_time, _iteration, consumed);
+		return;
+	}
+	PINF("CPU budget reached for %s (%llu us used)", _name.string(), consumed);
+	_kill(17);
 }
 
-void Task::_stop_start_timer()
+bool Task::_consumed_us(bool sample, unsigned long long& consumed)
 {
-	_start_timer.sigh(_idle_dispatcher);
-	_start_timer.trigger_once(0);
+	bool found = false;
+	consumed = 0;
+	for (Subject_cache::Entry& entry : _shared.subjects)
+	{
+		if (entry.task != this || entry.vanished)
+		{
+			continue;
+		}
+		if (sample)
+		{
+			const Genode::Trace::CPU_info info = _shared.trace.cpu_info(entry.id);
+			entry.state = info.state();
+			entry.execution_time = info.execution_time().value;
+		}
+		consumed += entry.execution_time;
+		found = true;
+	}
+	return found;
 }
 
-bool Task::_check_dynamic_elf(Genode::Attached_ram_dataspace& ds)
+void Task::_stop_timers()
 {
-	// Read program header.
-	Genode::Elf_binary elf((Genode::addr_t)ds.local_addr<char>());
-	return elf.is_dynamically_linked();
+	_plan.cancel();
+	_num_pending = 0;
+	_kill_timeout.cancel();
+	_budget_timeout.cancel();
+	_release_timeout.cancel();
 }
 
-std::string Task::_get_node_value(const Genode::Xml_node& config_node, const char* type, size_t max_len, const std::string& default_val)
+const char* Task::_find_last(const char* str, const char* pattern)
 {
-	if (config_node.has_sub_node(type))
+	const size_t pattern_len = Genode::strlen(pattern);
+	const char* found = nullptr;
+	for (const char* pos = str; *pos; ++pos)
 	{
-		std::vector<char> out(max_len);
-		config_node.sub_node(type).value(out.data(), max_len);
-		return out.data();
+		if (Genode::strcmp(pos, pattern, pattern_len) == 0)
+		{
+			found = pos;
+		}
 	}
-	return default_val;
+	return found;
 }
+
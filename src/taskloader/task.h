@@ -13,8 +13,22 @@
 #include <trace_session/connection.h>
 #include <util/noncopyable.h>
 #include <util/xml_node.h>
-#include "sched_controller_session/connection.h"
+#include <taskloader/task_descriptor.h>
 #include <base/affinity.h>
+#include <base/semaphore.h>
+
+#include "arena.h"
+#include "binary_store.h"
+#include "clock.h"
+#include "controller.h"
+#include "latency_histogram.h"
+#include "mode_switch.h"
+#include "placement.h"
+#include "profile_ring.h"
+#include "release_plan.h"
+#include "subject_cache.h"
+#include "timer_wheel.h"
+#include "wcet_estimator.h"
 
 // Noncopyable because dataspaces might get invalidated.
 class Task : Genode::Noncopyable
@@ -62,56 +76,32 @@ public:
 		Genode::Server server;
 	};
 
-	// Meta data that needs to be dynamically allocated on each start request.
-	struct Meta_ex : Meta
+	// Meta data that needs to be dynamically allocated on each start request. The sessions in meta may have been prepared before the release.
+	struct Meta_ex
 	{
 	public:
-		Meta_ex(Task& task);
+		Meta_ex(Task& task, Meta& meta);
 
+		Meta& meta;
 		Child_policy policy;
 		Genode::Child child;
 	};
 
-	// Single event of the profiling log data.
+	// Profiling event. The log itself is stored in Shared_data::profile, see taskloader/profile_log.h.
 	struct Event
 	{
-		struct Task_info
+		enum Type
 		{
-			struct Managed_info
-			{
-				// Task manager id.
-				int id;
-				size_t quota;
-				size_t used;
-				int iteration;
-			};
-
-			// Trace subject id. Pretty much useless.
-			unsigned id;
-
-			std::string session;
-			std::string thread;
-			Genode::Trace::CPU_info::State state;
-			unsigned long long execution_time;
-
-			// Managed by the task manager.
-			bool managed;
-			Managed_info managed_info;
+			START = Profile_log::START,
+			EXIT = Profile_log::EXIT,
+			EXIT_CRITICAL = Profile_log::EXIT_CRITICAL,
+			EXIT_ERROR = Profile_log::EXIT_ERROR,
+			EXIT_EXTERNAL = Profile_log::EXIT_EXTERNAL,
+			EXTERNAL = Profile_log::EXTERNAL,
+			DEADLINE_MISS = Profile_log::DEADLINE_MISS
 		};
-		enum Type { START = 0, EXIT, EXIT_CRITICAL, EXIT_ERROR, EXIT_EXTERNAL, EXTERNAL };
 
 		static const char* type_name(Type type);
-
-		// Event trigger type.
-		Type type;
-
-		// Task that triggered this event. -1 for EXTERNAL. 0 for task-manager.
-		int task_id;
-
-		// Time of trigger.
-		unsigned long time_stamp;
-
-		std::list<Task_info> task_infos;
 	};
 
 	struct Description
@@ -125,16 +115,69 @@ public:
 		unsigned int offset;
 		unsigned int number_of_jobs;
 		Genode::Number_of_bytes quota;
-		std::string binary_name;
+		char binary_name[Task_descriptor::PKG_LEN];
+
+		// Core the task was admitted on by the controller.
+		unsigned int core;
+
+		// What to do with a release while the previous instance is still running, from the <overrun> node.
+		enum Overrun
+		{
+			// Drop the release.
+			OVERRUN_SKIP = 0,
+			// Start it once the previous instance is gone, keeping up to max_queued releases.
+			OVERRUN_QUEUE,
+			// Kill the previous instance and start the release.
+			OVERRUN_KILL,
+			// Like OVERRUN_KILL, but start fallback_binary until a release finds no overrun.
+			OVERRUN_DEGRADE
+		};
+		Overrun overrun;
+		unsigned int max_queued;
+		char fallback_binary[Task_descriptor::PKG_LEN];
+	};
+
+	// Maximum of Description::max_queued.
+	enum { MAX_QUEUED = 8 };
+
+	// Task name, the id followed by the binary name.
+	enum { NAME_LEN = 4 + Task_descriptor::PKG_LEN };
+	typedef Genode::String<NAME_LEN> Name;
+
+	// Tasks live in the arena of Shared_data until the task set is cleared.
+	typedef std::list<Task, Arena_allocator<Task>> Task_list;
+
+	// Receives execution time estimates of tasks on the entrypoint, see <wcet-estimate>.
+	struct Estimate_handler
+	{
+		virtual ~Estimate_handler() { }
+		virtual void refine(Task& task, unsigned execution_time) = 0;
 	};
 
 	// Shared objects. There is only one instance per task manager. Rest are all references.
 	struct Shared_data
 	{
-		Shared_data(size_t trace_quota, size_t trace_buf_size);
+		// Non-owning view on a task name, so lookups from trace labels need no string allocation.
+		struct Name_key
+		{
+			const char* str;
+			size_t len;
+		};
+
+		struct Name_hash
+		{
+			size_t operator()(const Name_key& key) const;
+		};
+
+		struct Name_equal
+		{
+			bool operator()(const Name_key& a, const Name_key& b) const;
+		};
+
+		Shared_data(Server::Entrypoint& ep, const Genode::Xml_node& config, size_t trace_quota, size_t trace_buf_size, size_t profile_records, Subject_cache::Sampling sampling);
 
 		// All binaries loaded by the task manager.
-		std::unordered_map<std::string, Genode::Attached_ram_dataspace> binaries;
+		Binary_store binaries;
 
 		// Heap on which to create the init child.
 		Genode::Sliced_heap heap;
@@ -148,48 +191,160 @@ public:
 		// Trace connection used for execution time of tasks.
 		Genode::Trace::Connection trace;
 
-		// Log of task events, duh.
-		std::list<Task::Event> event_log;
+		// Known trace subjects. Protected by log_lock.
+		Subject_cache subjects;
+
+		// Log of task events, duh. Fixed size and shared with the client.
+		Profile_ring profile;
 
 		// Timer used for time stamps in event log.
 		Timer::Connection timer;
 
+		// Microsecond time stamps for latency measurements.
+		Clock clock;
+
+		// Release and kill timeouts of all tasks. Must outlive the tasks.
+		Timer_wheel wheel;
+
+		// Backs the task list. Reset when the task set is cleared.
+		Arena arena;
+
 		// List instead of vector because reallocation would invalidate dataspaces.
-		std::list<Task> tasks;
+		Task_list tasks;
+
+		// Lookup indices into tasks. Keys of tasks_by_name point into Task::_name. Protected by log_lock.
+		std::unordered_map<Name_key, Task*, Name_hash, Name_equal> tasks_by_name;
+		std::unordered_map<unsigned int, Task_list::iterator> tasks_by_id;
+
+		// Add a task to the lookup indices.
+		void index_task(Task_list::iterator task);
+
+		// Remove a task from the lookup indices before destroying it.
+		void unindex_task(Task& task);
+
+		// Remove all tasks from the lookup indices. Call before destroying tasks.
+		void clear_index();
+
+		// Global release options.
+		const Release_config release;
+
+		// Options for refining execution times from observed CPU times.
+		const Wcet_estimator::Config estimator;
+
+		// Criticality mode of the task set.
+		Mode_switch mode;
+
+		// Core assignment of admitted tasks.
+		Core_placement placement;
 
 		// Event logging may be called from multiple threads.
 		Genode::Lock log_lock;
+
+		// Cost of taskloader operations in us, see taskloader/timing_snapshot.h. Protected by log_lock.
+		Latency_histogram operation_costs[Timing_snapshot::NUM_OPERATIONS];
+		unsigned long long tasks_added;
+		unsigned long long bytes_uploaded;
+
+		// Account an operation that started at start_us (see clock) and ended now.
+		void record_cost(Timing_snapshot::Operation op, unsigned long long start_us);
+
+		// Signalled on the entrypoint after each child teardown, if valid.
+		Genode::Signal_context_capability teardown_sigh;
+
+		// Offered estimates that are due after a child teardown, if set.
+		Estimate_handler* estimate_handler;
 	};
 
-	Task(Server::Entrypoint& ep, Genode::Cap_connection& cap, Shared_data& shared, const Genode::Xml_node& node, Sched_controller::Connection* ctrl);
+	// Config is the XML text of the task's <config> node.
+	Task(Server::Entrypoint& ep, Genode::Cap_connection& cap, Shared_data& shared, const Description& desc, const char* config, size_t config_size, Controller* ctrl);
+
+	// Read all fields of a <periodictask> node in a single walk over its sub nodes. Config is set to the <config> sub node.
+	static void parse_description(const Genode::Xml_node& node, Description& desc, const char*& config, size_t& config_size);
 
-	// Warning: The Task dtor may be empty but tasks should be stopped before destroying them, preferably with a short wait inbetween to allow the child destructor thread to kill them properly.
+	// Convert a record of the binary task set format. Returns false if the record is invalid.
+	static bool parse_description(const Task_descriptor::Record& record, Description& desc);
+
+	// Warning: Tasks must be stopped and torn down (see wait_for_teardown()) before destroying them.
 	virtual ~Task();
 
+	// Release the first job at epoch + offset ms (see Timer_wheel::now()) and the following ones every period from there.
+	// A table-driven task arms no timeouts, a Cyclic_executive calls release_from_table() and kill_from_table() instead.
+	void run(unsigned long epoch, bool table_driven = false);
+	bool table_driven() const;
+	void release_from_table();
+	void kill_from_table();
+
+	// Same, with the epoch one lead time from now.
 	void run();
 	void stop();
-	std::string name() const;
+
+	// Whether the task has been run and not stopped since.
+	bool active() const;
+
+	// Replace the timing parameters (execution and critical time, priority, deadline, period, offset and number of jobs) by those of desc. The task must be stopped and torn down.
+	void update_timing(const Description& desc);
+
+	// Execution time estimate in ms to offer to the controller, or 0 if none is due. At most the specified execution time.
+	unsigned due_estimate();
+
+	// Replace the execution time by an estimate. May be called while the task runs.
+	void refine_execution_time(unsigned execution_time);
+
+	// Block until the child killed by stop() is destroyed.
+	void wait_for_teardown();
+	const char* name() const;
 	bool running() const;
+
+	// Whether the task has no child and the child destructor thread is done with it, so it may be destroyed.
+	bool torn_down() const;
 	const Description& desc() const;
 	Rq_task::Rq_task getRqTask();
 
-	static Task* task_by_name(std::list<Task>& tasks, const std::string& name);
-	static void log_profile_data(Event::Type type, int id, Shared_data& shared);
+	static Task* task_by_name(Shared_data& shared, const char* name, size_t len);
+	static Task* task_by_id(Shared_data& shared, unsigned int id);
+
+	// Position of the task with id in Shared_data::tasks, or tasks.end().
+	static Task_list::iterator task_iterator(Shared_data& shared, unsigned int id);
+	static void log_profile_data(Event::Type type, int id, Shared_data& shared, Profile_log::Deadline_miss miss = Profile_log::MISS_LATE);
+
+	// Copy the timing histograms. Call with Shared_data::log_lock held.
+	void timing(Timing_snapshot::Task_entry& entry) const;
+
+	// Share of jobs that missed their deadline (late, killed or skipped). Call with Shared_data::log_lock held.
+	double miss_ratio() const;
 
 	void setSchedulable(bool schedulable);
 	bool isSchedulable();
+	void setCore(unsigned int core);
+	double utilization() const;
 
 protected:
+	// Destroys exited children outside of their own threads. Sleeps until a child is submitted.
 	class Child_destructor_thread : Genode::Thread<2*4096>
 	{
 	public:
 		Child_destructor_thread();
 		void submit_for_destruction(Task* task);
 
+		// Block until the current child of task is destroyed. Returns immediately if there is none.
+		void wait_for_destruction(Task& task);
+
+		// Whether task has no child, checked under the lock held while a child is destroyed.
+		bool destroyed(const Task& task);
+
 	private:
+		struct Waiter
+		{
+			Task* task;
+			Genode::Semaphore* destroyed;
+		};
+
 		Genode::Lock _lock;
 		std::list<Task*> _queued;
-		Timer::Connection _timer;
+		std::list<Waiter> _waiters;
+
+		// Counts queued tasks.
+		Genode::Semaphore _pending;
 
 		void entry() override;
 	};
@@ -201,19 +356,24 @@ protected:
 	Description _desc;
 
 	Genode::Attached_ram_dataspace _config;
-	const std::string _name;
+	const Name _name;
 	int _iteration;
 
 	bool _paused;
 
-	// Periodic timers.
-	Timer::Connection _start_timer;
-	Timer::Connection _kill_timer;
+	// Release schedule driven by _release_timeout.
+	Release_plan _plan;
+
+	// Controller permission for all jobs if permissions are batched.
+	int _batch_permission;
 
-	// Timer dispatchers registering callbacks.
-	Genode::Signal_rpc_member<Task> _start_dispatcher;
-	Genode::Signal_rpc_member<Task> _kill_dispatcher;
-	Genode::Signal_rpc_member<Task> _idle_dispatcher;
+	// Releases and kills are driven by a Cyclic_executive.
+	bool _table_driven;
+
+	// Timeouts on the shared timer wheel.
+	Timer_wheel::Member<Task> _release_timeout;
+	Timer_wheel::Member<Task> _kill_timeout;
+	Timer_wheel::Member<Task> _budget_timeout;
 
 	// Child process entry point.
 	Genode::Rpc_entrypoint _child_ep;
@@ -221,37 +381,133 @@ protected:
 	// Child meta data.
 	Meta_ex* _meta;
 
+	// Sessions prepared for the next release if prefork is enabled.
+	Meta* _prepared;
+
+	// Binary of the current instance.
+	Binary_store::Blob* _binary;
+
+	// Signalled by the child destructor thread, starts a pending release or prepares the next instance on the entrypoint.
+	Genode::Signal_rpc_member<Task> _destroyed_dispatcher;
+
+	// Time stamp of the current release in us.
+	unsigned long long _release_us;
+
+	// Timing histograms in us, protected by Shared_data::log_lock. See taskloader/timing_snapshot.h.
+	Latency_histogram _release_latency;
+	Latency_histogram _response_time;
+	Latency_histogram _start_jitter;
+
+	// Job outcomes, protected by Shared_data::log_lock.
+	Timing_snapshot::Deadline_counts _deadlines;
+
+	// Outcomes of the overrun policy. Only touched on the entrypoint.
+	Timing_snapshot::Overrun_counts _overruns;
+
+	// CPU time per completed job and jobs over budget, protected by Shared_data::log_lock.
+	Wcet_estimator _cpu_time;
+	Timing_snapshot::Budget_counts _budget;
+
+	// Execution time of the description before refinement, which is also the CPU budget, and number of jobs observed when an estimate was last offered.
+	unsigned _specified_execution_time;
+	unsigned _estimated_jobs;
+
+	// Overrun releases waiting for the previous instance, FIFO of _num_pending entries at _first_pending.
+	struct Pending_release
+	{
+		unsigned long long release_us;
+		unsigned job;
+	};
+	Pending_release _pending[MAX_QUEUED];
+	unsigned _first_pending;
+	unsigned _num_pending;
+
+	// Releases start the fallback binary after an overrun with OVERRUN_DEGRADE.
+	bool _degraded;
+
+	// Number of jobs started, and time and job number of the last start for the jitter.
+	unsigned _jobs;
+	unsigned long long _last_start_us;
+	unsigned _last_start_job;
+
 	// Combine ID and binary name into a unique name, e.g. 01.namaste
-	std::string _make_name() const;
+	Name _make_name() const;
 
-	// Start task once.
-	void _start(unsigned);
-	void _kill_crit(unsigned);
+	// Release the next job of the plan and arm the timer for the one after.
+	void _release();
+	void _arm_release();
+
+	// Ask the controller whether a job of a deadline task may start. >0 start, 0 skip, <0 unknown to the controller.
+	int _permission(unsigned job);
+
+	// Tasks with priority 128 are scheduled by deadline and need controller permission per job.
+	bool _deadline_task() const;
+
+	// All other tasks are of high criticality, see Mode_switch.
+	bool _high_criticality() const;
+
+	// Drop or degrade a release of a low-criticality task in HI mode.
+	void _release_in_hi_mode(unsigned long long release_us, unsigned job);
+
+	// Create and transfer quota to the sessions of the next instance ahead of its release.
+	void _prepare();
+
+	// Handle destruction of the previous instance.
+	void _child_destroyed(unsigned);
+
+	// Destroy the child and its sessions.
+	void _destroy_meta();
+
+	// Drop the reference on the binary of the current instance.
+	void _release_binary();
+
+	// Start job of the release at release_us once.
+	void _start(unsigned long long release_us, unsigned job);
+
+	// Apply the overrun policy to a release that found the previous instance still running.
+	void _overrun(unsigned long long release_us, unsigned job);
+
+	// Kill the running instance and start the release once it is destroyed.
+	void _restart(unsigned long long release_us, unsigned job);
+
+	// Record release latency and start jitter of a job whose child was just activated.
+	void _record_start(unsigned job);
+
+	// Classify a finished job by its exit type and log a DEADLINE_MISS event if it missed. Called from the child thread.
+	void _record_exit(Event::Type type);
+
+	// Relative deadline in ms, 0 if neither deadline nor period are set.
+	unsigned _relative_deadline() const;
+	void _kill_crit();
 	void _kill(int exit_value = 1);
-	void _idle(unsigned);
+
+	// Whether jobs are limited by CPU time instead of the critical time, see Release_config::Budget.
+	bool _cpu_budget() const;
+
+	// Sample the CPU time of the running instance and apply the budget action once it exceeds the execution time.
+	void _check_budget();
+
+	// CPU time in us of the live trace subjects of the task, freshly sampled or as of the last sample. False if there are none. Call with Shared_data::log_lock held.
+	bool _consumed_us(bool sample, unsigned long long& consumed);
+
 	void _stop_timers();
-	void _stop_kill_timer();
-	void _stop_start_timer();
 
-	// Check if the provided ELF is dynamic by reading the header.
-	static bool _check_dynamic_elf(Genode::Attached_ram_dataspace& ds);
+	// Read the <overrun> node of a task description.
+	static void _parse_overrun(const Genode::Xml_node& node, Description& desc);
+
+	// Clamp and fix overrun settings of a description.
+	static void _check_overrun(Description& desc);
+
+	// Whether str is null-terminated within size bytes.
+	static bool _terminated(const char* str, size_t size);
+
+	// Fetch labels of a newly appeared trace subject and associate it with its task.
+	static void _resolve_subject(Subject_cache::Entry& entry, Shared_data& shared);
+
+	// Last occurrence of pattern in str, or nullptr.
+	static const char* _find_last(const char* str, const char* pattern);
 
-	// Get XML node value (not attribute) if it exists.
-	template <typename T>
-	static T _get_node_value(const Genode::Xml_node& config_node, const char* type, T default_val = T())
-	{
-		if (config_node.has_sub_node(type))
-		{
-			T out{};
-			config_node.sub_node(type).value<T>(&out);
-			return out;
-		}
-		return default_val;
-	}
-
-	// Get XML node string value (not attribute) if it exists.
-	static std::string _get_node_value(const Genode::Xml_node& config_node, const char* type, size_t max_len, const std::string& default_val = "");
 private:
 	bool _schedulable;
-	Sched_controller::Connection* _controller;
+	Controller* _controller;
 };
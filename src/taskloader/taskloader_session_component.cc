@@ -5,6 +5,7 @@
 #include <base/process.h>
 #include <util/xml_node.h>
 #include <util/xml_generator.h>
+#include <dataspace/client.h>
 
 #include <string>
 
@@ -14,9 +15,20 @@
 
 Taskloader_session_component::Taskloader_session_component(Server::Entrypoint& ep) :
 	_ep{ep},
-	_shared{_trace_quota(), _trace_buf_size()},
+	_shared{ep, Genode::config()->xml_node(), _trace_quota(), _trace_buf_size(), _profile_log_records(), _trace_sampling()},
 	_cap{},
-	_quota{Genode::env()->ram_session()->quota()}
+	_quota{Genode::env()->ram_session()->quota()},
+	_analysis{Genode::config()->xml_node()},
+	_executive{_shared.wheel, _shared.release},
+	_timing{nullptr},
+	_operations{},
+	_next_ticket{1},
+	_completed{0},
+	_completion_sigh{},
+	_operation_dispatcher{ep, *this, &Taskloader_session_component::_handle_operations},
+	_debug{Genode::config()->xml_node().attribute_value<bool>("debug", false)},
+	_estimates_unsupported{false},
+	_controller(*Controller::create(Genode::config()->xml_node()))
 {
 	// Load dynamic linker for dynamically linked binaries.
 	static Genode::Rom_connection ldso_rom("ld.lib.so");
@@ -33,82 +45,561 @@ Taskloader_session_component::Taskloader_session_component(Server::Entrypoint& e
 	{
 		_shared.parent_services.insert(new (Genode::env()->heap()) Genode::Parent_service(name));
 	}
+
+	_shared.teardown_sigh = _operation_dispatcher;
+	_shared.estimate_handler = this;
 }
 
 Taskloader_session_component::~Taskloader_session_component()
 {
+	if (_timing)
+	{
+		Genode::destroy(Genode::env()->heap(), _timing);
+	}
+	Genode::destroy(Genode::env()->heap(), &_controller);
 }
 
 void Taskloader_session_component::add_tasks(Genode::Ram_dataspace_capability xml_ds_cap)
 {
+	const unsigned long long start_us = _shared.clock.now_us();
 	Genode::Rm_session* rm = Genode::env()->rm_session();
 	const char* xml = rm->attach(xml_ds_cap);
-	PINF("Parsing XML file:\n%s", xml);
+	if (_debug)
+	{
+		PINF("Parsing XML file:\n%s", xml);
+	}
 	Genode::Xml_node root(xml);
-	Rq_task::Rq_task rq_task;
-
-	//Update rq_buffer before adding tasks for online analyses to core 1
-	sched.update_rq_buffer(1);
 
-	const auto fn = [this, &rq_task] (const Genode::Xml_node& node)
+	// Create all tasks first, so the whole set can be screened and looked up in the verdict cache at once.
+	std::vector<Task*> tasks;
+	const auto fn = [this, &tasks] (const Genode::Xml_node& node)
 	{
-		_shared.tasks.emplace_back(_ep, _cap, _shared, node, &sched);
-		//Add task to Controller to perform a schedulability test for core 1
-		rq_task = _shared.tasks.back().getRqTask();
-		int result = sched.new_task(rq_task, 1);
-		if (result != 0){
-			PINF("Task with id %d was not accepted by the controller", rq_task.task_id);
-			_shared.tasks.back().setSchedulable(false);
-		}
-		else{
-			PINF("Task with id %d was accepted by the controller", rq_task.task_id);
-			_shared.tasks.back().setSchedulable(true);
-		}
+		Task::Description desc;
+		const char* config;
+		size_t config_size;
+		Task::parse_description(node, desc, config, config_size);
+		tasks.push_back(&_create_task(desc, config, config_size));
 	};
 
 	root.for_each_sub_node("periodictask", fn);
 	rm->detach(xml);
+
+	_admit(tasks);
+	_shared.tasks_added += tasks.size();
+	_shared.record_cost(Timing_snapshot::OP_ADD_TASKS, start_us);
+}
+
+void Taskloader_session_component::add_tasks_binary(Genode::Ram_dataspace_capability descriptor_ds_cap)
+{
+	const unsigned long long start_us = _shared.clock.now_us();
+	Genode::Rm_session* rm = Genode::env()->rm_session();
+	const char* base = rm->attach(descriptor_ds_cap);
+	const size_t ds_size = Genode::Dataspace_client(descriptor_ds_cap).size();
+	if (ds_size < sizeof(Task_descriptor::Header))
+	{
+		PERR("Invalid task descriptor.");
+		rm->detach(base);
+		return;
+	}
+	// The client may still write to the dataspace. Copy everything that is validated and only use the copies afterwards.
+	Task_descriptor::Header header;
+	Genode::memcpy(&header, base, sizeof(header));
+
+	// Validate the whole layout before creating any task.
+	const Genode::uint64_t records_end = (Genode::uint64_t)header.records_offset + (Genode::uint64_t)header.num_tasks * header.record_size;
+	const Genode::uint64_t table_end = (Genode::uint64_t)header.config_table_offset + (Genode::uint64_t)header.num_tasks * sizeof(Task_descriptor::Config_entry);
+	if (header.magic != Task_descriptor::MAGIC || header.version == 0 || header.version > Task_descriptor::VERSION ||
+		header.size > ds_size || header.record_size == 0 || records_end > header.size || table_end > header.size)
+	{
+		PERR("Invalid task descriptor.");
+		rm->detach(base);
+		return;
+	}
+
+	const char* configs = base + header.config_table_offset;
+	std::vector<Task*> tasks;
+	for (Genode::uint32_t i = 0; i < header.num_tasks; ++i)
+	{
+		// Records of older versions may be shorter. Missing fields keep their default.
+		Task_descriptor::Record record{};
+		const size_t record_size = header.record_size < sizeof(record) ? header.record_size : sizeof(record);
+		Genode::memcpy(&record, base + header.records_offset + (size_t)i * header.record_size, record_size);
+
+		Task::Description desc;
+		Task_descriptor::Config_entry config;
+		Genode::memcpy(&config, configs + (size_t)i * sizeof(config), sizeof(config));
+		if (!Task::parse_description(record, desc) || (Genode::uint64_t)config.offset + config.size > header.size)
+		{
+			PERR("Invalid record %u in task descriptor, skipped.", i);
+			continue;
+		}
+		if (config.size == 0)
+		{
+			tasks.push_back(&_create_task(desc, "<config/>", Genode::strlen("<config/>")));
+		}
+		else
+		{
+			tasks.push_back(&_create_task(desc, base + config.offset, config.size));
+		}
+	}
+	rm->detach(base);
+
+	_admit(tasks);
+	_shared.tasks_added += tasks.size();
+	_shared.record_cost(Timing_snapshot::OP_ADD_TASKS, start_us);
+}
+
+Task& Taskloader_session_component::_create_task(const Task::Description& desc, const char* config, size_t config_size)
+{
+	_shared.tasks.emplace_back(_ep, _cap, _shared, desc, config, config_size, &_controller);
+	_shared.index_task(std::prev(_shared.tasks.end()));
+	return _shared.tasks.back();
+}
+
+void Taskloader_session_component::_admit(const std::vector<Task*>& tasks, bool use_cache)
+{
+	std::vector<Rq_task::Rq_task> rq_tasks;
+	for (Task* task : tasks)
+	{
+		rq_tasks.push_back(task->getRqTask());
+	}
+
+	const Genode::uint64_t fingerprint = _analysis.fingerprint(rq_tasks);
+	const std::vector<Schedulability_analysis::Verdict>* cached = use_cache ? _analysis.cached(fingerprint) : nullptr;
+	std::vector<Schedulability_analysis::Verdict> verdicts;
+
+	// The fingerprint does not depend on the order of the tasks, so match cached verdicts by task id.
+	if (cached && cached->size() == tasks.size())
+	{
+		std::vector<bool> used(cached->size(), false);
+		for (const Rq_task::Rq_task& rq_task : rq_tasks)
+		{
+			size_t j = 0;
+			while (j < cached->size() && (used[j] || (*cached)[j].task_id != rq_task.task_id))
+			{
+				++j;
+			}
+			if (j == cached->size())
+			{
+				break;
+			}
+			used[j] = true;
+			verdicts.push_back((*cached)[j]);
+		}
+		if (verdicts.size() == tasks.size())
+		{
+			PINF("Task set already analyzed, reusing %d controller verdict%s.", verdicts.size(), verdicts.size() == 1 ? "" : "s");
+		}
+		else
+		{
+			verdicts.clear();
+			cached = nullptr;
+		}
+	}
+
+	if (!cached)
+	{
+		bool rq_buffers_updated = false;
+		for (const Rq_task::Rq_task& rq_task : rq_tasks)
+		{
+			Schedulability_analysis::Verdict verdict{rq_task.task_id, false, 0};
+			const double utilization = rq_task.inter_arrival > 0 ? (double)rq_task.wcet / rq_task.inter_arrival : 0.0;
+
+			//Try cores in the order of the placement strategy, only asking the Controller for cores that pass the local analysis
+			unsigned cores[Core_placement::MAX_CORES];
+			const unsigned num_cores = _shared.placement.candidates(utilization, cores);
+			for (unsigned i = 0; i < num_cores && !verdict.accepted; ++i)
+			{
+				if (!_analysis.fits(cores[i], rq_task))
+				{
+					continue;
+				}
+
+				//Update rq_buffer before adding the first task for online analyses on all cores we may place tasks on
+				if (!rq_buffers_updated)
+				{
+					for (unsigned core = _shared.placement.first_core(); core < _shared.placement.num_cores(); ++core)
+					{
+						_controller.update_rq_buffer(core);
+					}
+					rq_buffers_updated = true;
+				}
+
+				if (_controller.new_task(rq_task, cores[i]) == 0)
+				{
+					verdict.accepted = true;
+					verdict.core = cores[i];
+					_analysis.add(cores[i], rq_task);
+				}
+			}
+			verdicts.push_back(verdict);
+		}
+		_analysis.store(fingerprint, verdicts);
+	}
+
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		Task& task = *tasks[i];
+		const Schedulability_analysis::Verdict& verdict = verdicts[i];
+		if (!verdict.accepted){
+			PINF("Task with id %d was not accepted by the controller on any core", verdict.task_id);
+			task.setSchedulable(false);
+		}
+		else{
+			PINF("Task with id %d was accepted by the controller on core %u", verdict.task_id, verdict.core);
+			task.setCore(verdict.core);
+			task.setSchedulable(true);
+			_shared.placement.assign(verdict.core, task.utilization());
+			if (cached)
+			{
+				_analysis.add(verdict.core, rq_tasks[i]);
+			}
+		}
+	}
 }
 
 void Taskloader_session_component::clear_tasks()
 {
-	PDBG("Clearing %d task%s. Binaries still held.", _shared.tasks.size(), _shared.tasks.size() == 1 ? "" : "s");
+	const unsigned long long start_us = _shared.clock.now_us();
+	PDBG("Clearing %d task%s. Binaries are kept until released.", _shared.tasks.size(), _shared.tasks.size() == 1 ? "" : "s");
+	// Returns once all children are destroyed.
 	stop();
-
-	// Wait for task destruction.
-	_shared.timer.msleep(500);
-	_shared.tasks.clear();
+	_clear();
+	_shared.record_cost(Timing_snapshot::OP_CLEAR_TASKS, start_us);
 }
 
 Genode::Ram_dataspace_capability Taskloader_session_component::binary_ds(Genode::Ram_dataspace_capability name_ds_cap, size_t size)
 {
+	const unsigned long long start_us = _shared.clock.now_us();
 	Genode::Rm_session* rm = Genode::env()->rm_session();
 	const char* name = rm->attach(name_ds_cap);
 	PDBG("Reserving %d bytes for binary %s", size, name);
-	Genode::Ram_session* ram = Genode::env()->ram_session();
 
-	// Hoorray for C++ syntax. This basically forwards ctor arguments, constructing the dataspace in-place so there is no copy or dtor call involved which may invalidate the attached pointer.
-	// Also, emplace returns a <iterator, bool> pair indicating insertion success, so we need .first to get the map iterator and ->second to get the actual dataspace.
-	Genode::Attached_ram_dataspace& ds = _shared.binaries.emplace(std::piecewise_construct, std::make_tuple(name), std::make_tuple(ram, size)).first->second;
+	// A new dataspace each time. The content is compared to the other binaries once it is used.
+	Genode::Ram_dataspace_capability cap = _shared.binaries.upload(name, size);
+	rm->detach(name);
+	_shared.bytes_uploaded += size;
+	_shared.record_cost(Timing_snapshot::OP_BINARY_DS, start_us);
+	return cap;
+}
+
+void Taskloader_session_component::release_binary(Genode::Ram_dataspace_capability name_ds_cap)
+{
+	Genode::Rm_session* rm = Genode::env()->rm_session();
+	const char* name = rm->attach(name_ds_cap);
+	if (!_shared.binaries.remove(name))
+	{
+		PWRN("Binary %s to release not found.", name);
+	}
 	rm->detach(name);
-	return ds.cap();
 }
 
 void Taskloader_session_component::start()
 {
+	const unsigned long long start_us = _shared.clock.now_us();
 	PINF("Starting %d task%s.", _shared.tasks.size(), _shared.tasks.size() == 1 ? "" : "s");
+
+	// Uploads are complete by now. Deduplicate before the first release instead of on it.
+	_shared.binaries.seal_all();
+
+	// One epoch for the whole set, so the phasing of the tasks is given by their offsets alone.
+	const unsigned long epoch = _shared.wheel.now() + _shared.release.lead;
+
+	std::vector<Task*> schedulable;
 	for (Task& task : _shared.tasks)
 	{
 		if (task.isSchedulable())
 		{
-			task.run();
+			schedulable.push_back(&task);
 		}
 	}
+
+	const bool table_driven = _shared.release.dispatch == Release_config::DISPATCH_TABLE && _executive.build(schedulable);
+	for (Task* task : schedulable)
+	{
+		task->run(epoch, table_driven);
+	}
+	if (table_driven)
+	{
+		_executive.start(epoch);
+	}
+
+	_shared.record_cost(Timing_snapshot::OP_START, start_us);
 }
 
 void Taskloader_session_component::stop()
+{
+	_stop_all();
+
+	// Kill all children first, then wait for their teardown together.
+	for (Task& task : _shared.tasks)
+	{
+		task.wait_for_teardown();
+	}
+}
+
+Genode::Ram_dataspace_capability Taskloader_session_component::profile_ds()
+{
+	return _shared.profile.cap();
+}
+
+Genode::Ram_dataspace_capability Taskloader_session_component::timing_ds()
+{
+	const size_t size = sizeof(Timing_snapshot::Header) + _shared.tasks.size() * sizeof(Timing_snapshot::Task_entry);
+	if (!_timing || _timing->size() < size)
+	{
+		if (_timing)
+		{
+			Genode::destroy(Genode::env()->heap(), _timing);
+		}
+		_timing = new (Genode::env()->heap()) Genode::Attached_ram_dataspace(Genode::env()->ram_session(), size);
+	}
+
+	Timing_snapshot::Header& header = *_timing->local_addr<Timing_snapshot::Header>();
+	Timing_snapshot::Task_entry* entries = reinterpret_cast<Timing_snapshot::Task_entry*>(&header + 1);
+
+	// Children update their histograms on exit, so copy under the log lock.
+	Genode::Lock::Guard guard(_shared.log_lock);
+	header.time_stamp = _shared.clock.now_us();
+	header.num_tasks = _shared.tasks.size();
+	header.entry_size = sizeof(Timing_snapshot::Task_entry);
+	header.num_buckets = Timing_snapshot::NUM_BUCKETS;
+	header.sub_bucket_bits = Timing_snapshot::SUB_BUCKET_BITS;
+	header.tasks_added = _shared.tasks_added;
+	header.bytes_uploaded = _shared.bytes_uploaded;
+	for (unsigned op = 0; op < Timing_snapshot::NUM_OPERATIONS; ++op)
+	{
+		header.operations[op] = _shared.operation_costs[op].data();
+	}
+	_shared.mode.counts(header.mode);
+
+	size_t i = 0;
+	for (const Task& task : _shared.tasks)
+	{
+		task.timing(entries[i++]);
+	}
+	return _timing->cap();
+}
+
+bool Taskloader_session_component::remove_task(unsigned id)
+{
+	const Task::Task_list::iterator it = Task::task_iterator(_shared, id);
+	if (it == _shared.tasks.end())
+	{
+		return false;
+	}
+
+	PINF("Removing task %s.", it->name());
+	_executive.forget(&*it);
+	it->stop();
+	it->wait_for_teardown();
+	if (!_withdraw(*it))
+	{
+		PWRN("Controller cannot withdraw task %s, it stays accounted there.", it->name());
+	}
+	_unaccount(*it);
+	_shared.unindex_task(*it);
+	_shared.tasks.erase(it);
+	return true;
+}
+
+bool Taskloader_session_component::update_task(unsigned id, Task_timing timing)
+{
+	Task* task = Task::task_by_id(_shared, id);
+	if (!task)
+	{
+		return false;
+	}
+
+	// Submitting the new timing next to the old one would count the task twice.
+	if (!_withdraw(*task))
+	{
+		PWRN("Controller cannot withdraw task %s, keeping its timing.", task->name());
+		return false;
+	}
+
+	// The dispatch table was computed for the old timing, restarts are task-driven.
+	_executive.forget(task);
+
+	const bool active = task->active();
+	if (active)
+	{
+		task->stop();
+		task->wait_for_teardown();
+	}
+	_unaccount(*task);
+
+	Task::Description desc = task->desc();
+	desc.execution_time = timing.execution_time;
+	desc.critical_time = timing.critical_time;
+	desc.priority = timing.priority;
+	desc.deadline = timing.deadline;
+	desc.period = timing.period;
+	desc.offset = timing.offset;
+	desc.number_of_jobs = timing.number_of_jobs;
+	task->update_timing(desc);
+
+	// Only this task is offered to the controller again. Always ask, the controller only knows the timing it saw last.
+	_admit(std::vector<Task*>{task}, false);
+	if (active && task->isSchedulable())
+	{
+		task->run();
+	}
+	return task->isSchedulable();
+}
+
+bool Taskloader_session_component::start_task(unsigned id)
+{
+	Task* task = Task::task_by_id(_shared, id);
+	if (!task)
+	{
+		return false;
+	}
+	if (task->isSchedulable() && !task->active())
+	{
+		_shared.binaries.seal_all();
+		task->run();
+	}
+	return true;
+}
+
+bool Taskloader_session_component::stop_task(unsigned id)
+{
+	Task* task = Task::task_by_id(_shared, id);
+	if (!task)
+	{
+		return false;
+	}
+	task->stop();
+	task->wait_for_teardown();
+	return true;
+}
+
+bool Taskloader_session_component::_withdraw(Task& task)
+{
+	if (!task.isSchedulable())
+	{
+		return true;
+	}
+	return _controller.withdraw(task.desc().id, task.desc().core);
+}
+
+void Taskloader_session_component::_unaccount(Task& task)
+{
+	if (!task.isSchedulable())
+	{
+		return;
+	}
+	_shared.placement.release(task.desc().core, task.utilization());
+	_analysis.remove(task.desc().core, task.getRqTask());
+}
+
+void Taskloader_session_component::completion_sigh(Genode::Signal_context_capability sigh)
+{
+	_completion_sigh = sigh;
+}
+
+unsigned Taskloader_session_component::submit(Operation op, Genode::Ram_dataspace_capability ds)
+{
+	const unsigned ticket = _next_ticket++;
+	_operations.push_back(Pending_operation{op, ticket, ds, false, 0});
+	Genode::Signal_transmitter(_operation_dispatcher).submit();
+	return ticket;
+}
+
+unsigned Taskloader_session_component::completed()
+{
+	return _completed;
+}
+
+void Taskloader_session_component::_handle_operations(unsigned)
+{
+	while (!_operations.empty())
+	{
+		Pending_operation& operation = _operations.front();
+		switch (operation.op)
+		{
+			case ADD_TASKS:
+				add_tasks(operation.ds);
+				break;
+			case ADD_TASKS_BINARY:
+				add_tasks_binary(operation.ds);
+				break;
+			case START:
+				start();
+				break;
+			case STOP:
+			case CLEAR_TASKS:
+				if (!operation.stopping)
+				{
+					operation.start_us = _shared.clock.now_us();
+					_stop_all();
+					operation.stopping = true;
+				}
+				// Resumed by the teardown signal of the last child.
+				if (!_torn_down())
+				{
+					return;
+				}
+				if (operation.op == CLEAR_TASKS)
+				{
+					_clear();
+					_shared.record_cost(Timing_snapshot::OP_CLEAR_TASKS, operation.start_us);
+				}
+				break;
+		}
+
+		_completed = operation.ticket;
+		_operations.pop_front();
+		if (_completion_sigh.valid())
+		{
+			Genode::Signal_transmitter(_completion_sigh).submit();
+		}
+	}
+}
+
+void Taskloader_session_component::refine(Task& task, unsigned execution_time)
+{
+	if (_estimates_unsupported)
+	{
+		return;
+	}
+
+	// Replace the entry of the task on its core, placement stays the same.
+	const unsigned core = task.desc().core;
+	const unsigned admitted = task.desc().execution_time;
+	const Rq_task::Rq_task old_rq_task = task.getRqTask();
+	if (!_controller.withdraw(task.desc().id, core))
+	{
+		PWRN("Controller cannot replace tasks, not offering execution time estimates.");
+		_estimates_unsupported = true;
+		return;
+	}
+	_shared.placement.release(core, task.utilization());
+	_analysis.remove(core, old_rq_task);
+
+	task.refine_execution_time(execution_time);
+	const Rq_task::Rq_task rq_task = task.getRqTask();
+	_controller.update_rq_buffer(core);
+	if (_analysis.fits(core, rq_task) && _controller.new_task(rq_task, core) == 0)
+	{
+		PINF("Refined execution time of %s from %u ms to %u ms.", task.name(), admitted, execution_time);
+	}
+	else
+	{
+		// Restore the entry the controller accepted before.
+		PINF("Estimate for %s not accepted on core %u, keeping %u ms.", task.name(), core, admitted);
+		task.refine_execution_time(admitted);
+		_controller.new_task(old_rq_task, core);
+	}
+	_analysis.add(core, task.getRqTask());
+	_shared.placement.assign(core, task.utilization());
+}
+
+void Taskloader_session_component::_stop_all()
 {
 	PINF("Stopping all tasks.");
+	_executive.stop();
 	for (Task& task : _shared.tasks)
 	{
 		if (task.isSchedulable())
@@ -118,6 +609,35 @@ void Taskloader_session_component::stop()
 	}
 }
 
+bool Taskloader_session_component::_torn_down() const
+{
+	for (const Task& task : _shared.tasks)
+	{
+		// Under the lock of the destructor thread, which uses the task until it is done with the child.
+		if (!task.torn_down())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void Taskloader_session_component::_clear()
+{
+	// Cached trace subjects and lookup indices refer to the tasks.
+	{
+		Genode::Lock::Guard guard(_shared.log_lock);
+		_shared.subjects.flush();
+	}
+	_executive.clear();
+	_shared.clear_index();
+	_shared.tasks.clear();
+	_shared.arena.reset();
+	_shared.placement.reset();
+	_analysis.reset();
+	_controller.reset();
+}
+
 Genode::Number_of_bytes Taskloader_session_component::_trace_quota()
 {
 	Genode::Xml_node launchpad_node = Genode::config()->xml_node().sub_node("trace");
@@ -129,3 +649,14 @@ Genode::Number_of_bytes Taskloader_session_component::_trace_buf_size()
 	Genode::Xml_node launchpad_node = Genode::config()->xml_node().sub_node("trace");
 	return launchpad_node.attribute_value<Genode::Number_of_bytes>("buf-size", 64 * 1024);
 }
+
+size_t Taskloader_session_component::_profile_log_records()
+{
+	Genode::Xml_node launchpad_node = Genode::config()->xml_node().sub_node("trace");
+	return launchpad_node.attribute_value<unsigned>("log-records", 4096);
+}
+
+Subject_cache::Sampling Taskloader_session_component::_trace_sampling()
+{
+	return Subject_cache::sampling_from_config(Genode::config()->xml_node().sub_node("trace"));
+}
@@ -2,19 +2,23 @@
 
 #include <list>
 #include <unordered_map>
+#include <vector>
 
 #include <base/signal.h>
 #include <taskloader/taskloader_session.h>
 #include <os/attached_ram_dataspace.h>
 #include <os/server.h>
+#include <os/signal_rpc_dispatcher.h>
 #include <root/component.h>
 #include <timer_session/connection.h>
 #include <util/string.h>
-#include "sched_controller_session/connection.h"
 
+#include "controller.h"
+#include "cyclic_executive.h"
+#include "schedulability.h"
 #include "task.h"
 
-struct Taskloader_session_component : Genode::Rpc_object<Taskloader_session>
+struct Taskloader_session_component : Genode::Rpc_object<Taskloader_session>, Task::Estimate_handler
 {
 public:
 	Taskloader_session_component(Server::Entrypoint& ep);
@@ -23,18 +27,41 @@ public:
 	// Create tasks in idle state from XML description.
 	void add_tasks(Genode::Ram_dataspace_capability xml_ds_cap);
 
+	// Create tasks in idle state from a binary descriptor, see taskloader/task_descriptor.h.
+	void add_tasks_binary(Genode::Ram_dataspace_capability descriptor_ds_cap);
+
 	// Allocate and return a capability of a new dataspace to be used for a task binary.
 	Genode::Ram_dataspace_capability binary_ds(Genode::Ram_dataspace_capability name_ds_cap, size_t size);
 
+	// Forget the binary of the name stored in name_ds_cap. Its dataspace is freed once no task uses it.
+	void release_binary(Genode::Ram_dataspace_capability name_ds_cap);
+
 	// Destruct all tasks.
 	void clear_tasks();
 
 	// Start idle tasks.
 	void start();
 
-	// Stop all tasks.
+	// Stop all tasks. Returns once their children are destroyed.
 	void stop();
 
+	// Operations on single tasks by id, see Taskloader_session.
+	bool remove_task(unsigned id);
+	bool update_task(unsigned id, Task_timing timing);
+	bool start_task(unsigned id);
+	bool stop_task(unsigned id);
+
+	// Return the dataspace of the profiling log ring.
+	Genode::Ram_dataspace_capability profile_ds();
+
+	// Take a snapshot of the timing histograms of all tasks and return its dataspace.
+	Genode::Ram_dataspace_capability timing_ds();
+
+	// Asynchronous operations, see Taskloader_session::submit().
+	void completion_sigh(Genode::Signal_context_capability sigh);
+	unsigned submit(Operation op, Genode::Ram_dataspace_capability ds);
+	unsigned completed();
+
 	
 protected:
 	Server::Entrypoint& _ep;
@@ -43,11 +70,76 @@ protected:
 
 	size_t _quota;
 
+	// Local pre-screening and verdict cache for controller admission.
+	Schedulability_analysis _analysis;
+
+	// Dispatch table for <release dispatch="table"/>.
+	Cyclic_executive _executive;
+
+	// Timing snapshot, reallocated when the task set outgrows it.
+	Genode::Attached_ram_dataspace* _timing;
+
+	// Queued asynchronous operation.
+	struct Pending_operation
+	{
+		Operation op;
+		unsigned ticket;
+		Genode::Ram_dataspace_capability ds;
+
+		// STOP and CLEAR_TASKS have killed all children at start_us and wait for their teardown.
+		bool stopping;
+		unsigned long long start_us;
+	};
+
+	std::list<Pending_operation> _operations;
+	unsigned _next_ticket;
+	unsigned _completed;
+	Genode::Signal_context_capability _completion_sigh;
+
+	// Runs queued operations. Also signalled after each child teardown, to resume a waiting STOP or CLEAR_TASKS.
+	Genode::Signal_rpc_member<Taskloader_session_component> _operation_dispatcher;
+
+	void _handle_operations(unsigned);
+
+	// Kill all children without waiting for their teardown.
+	void _stop_all();
+
+	// Whether no task has a child left.
+	bool _torn_down() const;
+
+	// Destroy all tasks. They must be torn down.
+	void _clear();
+
+	// Log full task descriptions.
+	const bool _debug;
+
+	// Create a task and add it to the lookup indices.
+	Task& _create_task(const Task::Description& desc, const char* config, size_t config_size);
+
+	// Withdraw an admitted task from the controller. False if the controller still accounts for it.
+	bool _withdraw(Task& task);
+
+	// Undo the core placement and analysis accounting of an admitted task.
+	void _unaccount(Task& task);
+
+	// Admit newly created tasks through local analysis and the controller, and place them on cores.
+	// Without use_cache, the controller is asked even if the task set has been analyzed before.
+	void _admit(const std::vector<Task*>& tasks, bool use_cache = true);
+
+	// Offer an execution time estimate of an admitted task to the controller on its core in place of its current entry, see <wcet-estimate>.
+	void refine(Task& task, unsigned execution_time) override;
+
+	// The controller cannot replace tasks, so estimates are not offered.
+	bool _estimates_unsupported;
+
 	static Genode::Number_of_bytes _trace_quota();
 	static Genode::Number_of_bytes _trace_buf_size();
+	static size_t _profile_log_records();
+	static Subject_cache::Sampling _trace_sampling();
 
 private:
-	Sched_controller::Connection sched;
+	// Remote sched-controller or in-process stub, see <controller>.
+	Controller& _controller;
 };
 
 struct Taskloader_root_component : Genode::Root_component<Taskloader_session_component>
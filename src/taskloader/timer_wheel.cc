@@ -0,0 +1,293 @@
+#include "timer_wheel.h"
+
+Timer_wheel::Entry::Entry(Timer_wheel& wheel) :
+	_wheel(wheel),
+	_slot{nullptr},
+	_prev{nullptr},
+	_next{nullptr},
+	_expiry{0},
+	_period{0}
+{
+}
+
+Timer_wheel::Entry::~Entry()
+{
+	cancel();
+}
+
+void Timer_wheel::Entry::schedule(unsigned long expiry_ms, unsigned long period_ms)
+{
+	if (_slot)
+	{
+		_wheel._unlink(*this);
+	}
+	_expiry = expiry_ms;
+	_period = period_ms;
+	_wheel._insert(*this);
+	_wheel._program();
+}
+
+void Timer_wheel::Entry::schedule_in(unsigned long delay_ms, unsigned long period_ms)
+{
+	schedule(_wheel.now() + delay_ms, period_ms);
+}
+
+void Timer_wheel::Entry::cancel()
+{
+	if (_slot)
+	{
+		_wheel._unlink(*this);
+		_wheel._program();
+	}
+}
+
+bool Timer_wheel::Entry::armed() const
+{
+	return _slot != nullptr;
+}
+
+unsigned long Timer_wheel::Entry::expiry() const
+{
+	return _expiry;
+}
+
+
+
+Timer_wheel::Timer_wheel(Server::Entrypoint& ep) :
+	_timer{},
+	_dispatcher{ep, *this, &Timer_wheel::_handle},
+	_levels{},
+	_overflow{nullptr, 2, 0},
+	_current{0},
+	_programmed{0}
+{
+	for (int level = 0; level < 2; ++level)
+	{
+		for (unsigned index = 0; index < NUM_SLOTS; ++index)
+		{
+			_levels[level].slots[index] = Slot{nullptr, level, index};
+		}
+	}
+	_timer.sigh(_dispatcher);
+	_current = _timer.elapsed_ms();
+}
+
+unsigned long Timer_wheel::now()
+{
+	return _timer.elapsed_ms();
+}
+
+void Timer_wheel::_handle(unsigned)
+{
+	_programmed = 0;
+	_advance(now());
+	_program();
+}
+
+void Timer_wheel::_advance(unsigned long time)
+{
+	while (_current < time)
+	{
+		const unsigned long block = _current & ~(unsigned long)SLOT_MASK;
+		const unsigned long block_end = block + NUM_SLOTS;
+		const unsigned index = _find(_levels[0].bitmap, (_current & SLOT_MASK) + 1);
+		const unsigned long next = index < NUM_SLOTS ? block + index : block_end;
+
+		if (next > time)
+		{
+			_current = time;
+			break;
+		}
+
+		_current = next;
+		if (next == block_end)
+		{
+			_cascade();
+		}
+		_expire(_current & SLOT_MASK);
+	}
+}
+
+void Timer_wheel::_cascade()
+{
+	// Overflow entries are sorted into the levels again each time level 1 wraps.
+	if ((_current & ((1ul << (2 * SLOT_BITS)) - 1)) == 0)
+	{
+		Slot pending{nullptr, -1, 0};
+		while (_overflow.head)
+		{
+			Entry& entry = *_overflow.head;
+			_unlink(entry);
+			_link(pending, entry);
+		}
+		while (pending.head)
+		{
+			Entry& entry = *pending.head;
+			_unlink(entry);
+			_place(entry);
+		}
+	}
+
+	Slot& slot = _levels[1].slots[(_current >> SLOT_BITS) & SLOT_MASK];
+	while (slot.head)
+	{
+		Entry& entry = *slot.head;
+		_unlink(entry);
+		_place(entry);
+	}
+}
+
+void Timer_wheel::_expire(unsigned index)
+{
+	// Detach the slot first, handlers may arm and cancel entries.
+	Slot& slot = _levels[0].slots[index];
+	Slot due{nullptr, -1, 0};
+	while (slot.head)
+	{
+		Entry& entry = *slot.head;
+		_unlink(entry);
+		_link(due, entry);
+	}
+
+	while (due.head)
+	{
+		Entry& entry = *due.head;
+		_unlink(entry);
+
+		// Re-arm relative to the planned expiry, not to now, so periodic entries do not drift.
+		if (entry._period > 0)
+		{
+			entry._expiry += entry._period;
+			_insert(entry);
+		}
+		entry._expired();
+	}
+}
+
+unsigned long Timer_wheel::_next_expiry() const
+{
+	unsigned index = _find(_levels[0].bitmap, (_current & SLOT_MASK) + 1);
+	if (index < NUM_SLOTS)
+	{
+		return (_current & ~(unsigned long)SLOT_MASK) + index;
+	}
+
+	index = _find(_levels[1].bitmap, ((_current >> SLOT_BITS) & SLOT_MASK) + 1);
+	if (index < NUM_SLOTS)
+	{
+		return _earliest(_levels[1].slots[index]);
+	}
+
+	return _overflow.head ? _earliest(_overflow) : 0;
+}
+
+void Timer_wheel::_program()
+{
+	const unsigned long next = _next_expiry();
+	if (next == 0 || next == _programmed)
+	{
+		return;
+	}
+
+	// A new one-shot timeout replaces the pending one.
+	const unsigned long time = now();
+	_timer.trigger_once(next > time ? (next - time) * 1000 : 0);
+	_programmed = next;
+}
+
+void Timer_wheel::_insert(Entry& entry)
+{
+	// Everything up to _current has already expired.
+	if (entry._expiry <= _current)
+	{
+		entry._expiry = _current + 1;
+	}
+	_place(entry);
+}
+
+void Timer_wheel::_place(Entry& entry)
+{
+	const unsigned long expiry = entry._expiry;
+	if ((expiry >> SLOT_BITS) == (_current >> SLOT_BITS))
+	{
+		_link(_levels[0].slots[expiry & SLOT_MASK], entry);
+	}
+	else if ((expiry >> (2 * SLOT_BITS)) == (_current >> (2 * SLOT_BITS)))
+	{
+		_link(_levels[1].slots[(expiry >> SLOT_BITS) & SLOT_MASK], entry);
+	}
+	else
+	{
+		_link(_overflow, entry);
+	}
+}
+
+void Timer_wheel::_link(Slot& slot, Entry& entry)
+{
+	entry._slot = &slot;
+	entry._prev = nullptr;
+	entry._next = slot.head;
+	if (slot.head)
+	{
+		slot.head->_prev = &entry;
+	}
+	slot.head = &entry;
+
+	if (slot.level == 0 || slot.level == 1)
+	{
+		_levels[slot.level].bitmap[slot.index / 64] |= 1ull << (slot.index % 64);
+	}
+}
+
+void Timer_wheel::_unlink(Entry& entry)
+{
+	Slot& slot = *entry._slot;
+	if (entry._prev)
+	{
+		entry._prev->_next = entry._next;
+	}
+	else
+	{
+		slot.head = entry._next;
+	}
+	if (entry._next)
+	{
+		entry._next->_prev = entry._prev;
+	}
+	entry._slot = nullptr;
+	entry._prev = nullptr;
+	entry._next = nullptr;
+
+	if (!slot.head && (slot.level == 0 || slot.level == 1))
+	{
+		_levels[slot.level].bitmap[slot.index / 64] &= ~(1ull << (slot.index % 64));
+	}
+}
+
+unsigned Timer_wheel::_find(const Genode::uint64_t* bitmap, unsigned from)
+{
+	unsigned index = from;
+	while (index < NUM_SLOTS)
+	{
+		const Genode::uint64_t bits = bitmap[index / 64] >> (index % 64);
+		if (bits)
+		{
+			return index + __builtin_ctzll(bits);
+		}
+		index = (index / 64 + 1) * 64;
+	}
+	return NUM_SLOTS;
+}
+
+unsigned long Timer_wheel::_earliest(const Slot& slot)
+{
+	unsigned long earliest = ~0ul;
+	for (const Entry* entry = slot.head; entry; entry = entry->_next)
+	{
+		if (entry->_expiry < earliest)
+		{
+			earliest = entry->_expiry;
+		}
+	}
+	return earliest;
+}
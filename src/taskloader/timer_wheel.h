@@ -0,0 +1,141 @@
+#pragma once
+
+#include <base/stdint.h>
+#include <os/server.h>
+#include <os/signal_rpc_dispatcher.h>
+#include <timer_session/connection.h>
+#include <util/noncopyable.h>
+
+// Hierarchical timer wheel multiplexing all timeouts of the task manager onto a single timer session.
+//
+// Level 0 has one slot per ms of the current 256 ms block, level 1 one slot per block of the current 64 s period. Timeouts beyond that wait in an overflow list.
+// Arming and cancelling is O(1). The timer session is always programmed to the earliest armed expiry, so there are no periodic ticks.
+// Entries must only be armed, cancelled and destroyed on the entrypoint thread that dispatches the timer signal.
+class Timer_wheel : Genode::Noncopyable
+{
+public:
+	class Entry;
+
+protected:
+	// Doubly linked list of entries with a common slot.
+	struct Slot
+	{
+		Entry* head;
+		int level;
+		unsigned index;
+	};
+
+public:
+	class Entry : Genode::Noncopyable
+	{
+	public:
+		Entry(Timer_wheel& wheel);
+		virtual ~Entry();
+
+		// Expire at the absolute time expiry_ms (see Timer_wheel::now()). A non-zero period re-arms the entry at expiry + period before each call.
+		void schedule(unsigned long expiry_ms, unsigned long period_ms = 0);
+
+		// Expire delay_ms from now.
+		void schedule_in(unsigned long delay_ms, unsigned long period_ms = 0);
+
+		void cancel();
+		bool armed() const;
+
+		// Time the entry expires next.
+		unsigned long expiry() const;
+
+	protected:
+		virtual void _expired() = 0;
+
+	private:
+		friend class Timer_wheel;
+
+		Timer_wheel& _wheel;
+		Slot* _slot;
+		Entry* _prev;
+		Entry* _next;
+		unsigned long _expiry;
+		unsigned long _period;
+	};
+
+	// Entry calling a member function on expiry, analogous to Genode::Signal_rpc_member.
+	template <typename T>
+	class Member : public Entry
+	{
+	public:
+		Member(Timer_wheel& wheel, T& obj, void (T::*fn)()) :
+			Entry{wheel},
+			_obj(obj),
+			_fn{fn}
+		{
+		}
+
+	protected:
+		void _expired() override
+		{
+			(_obj.*_fn)();
+		}
+
+	private:
+		T& _obj;
+		void (T::*_fn)();
+	};
+
+	Timer_wheel(Server::Entrypoint& ep);
+
+	// Current time in ms.
+	unsigned long now();
+
+protected:
+	enum
+	{
+		SLOT_BITS = 8,
+		NUM_SLOTS = 1 << SLOT_BITS,
+		SLOT_MASK = NUM_SLOTS - 1,
+		BITMAP_WORDS = NUM_SLOTS / 64
+	};
+
+	struct Level
+	{
+		Slot slots[NUM_SLOTS];
+		Genode::uint64_t bitmap[BITMAP_WORDS];
+	};
+
+	Timer::Connection _timer;
+	Genode::Signal_rpc_member<Timer_wheel> _dispatcher;
+
+	Level _levels[2];
+	Slot _overflow;
+
+	// All entries up to and including this time have been expired.
+	unsigned long _current;
+
+	// Expiry the timer session is currently programmed for, 0 if none.
+	unsigned long _programmed;
+
+	void _handle(unsigned);
+
+	// Expire everything up to time.
+	void _advance(unsigned long time);
+
+	// Move entries of the level 1 slot that becomes current (and overflow entries at a level 1 wrap) down.
+	void _cascade();
+
+	// Expire all entries of level 0 slot index.
+	void _expire(unsigned index);
+
+	// Earliest expiry of all armed entries, 0 if none.
+	unsigned long _next_expiry() const;
+
+	void _program();
+
+	// Link entry into the slot for its expiry, moving expiries in the past to the next ms.
+	void _insert(Entry& entry);
+	void _place(Entry& entry);
+	void _link(Slot& slot, Entry& entry);
+	void _unlink(Entry& entry);
+
+	// Index of first set bit at or after from, or NUM_SLOTS.
+	static unsigned _find(const Genode::uint64_t* bitmap, unsigned from);
+	static unsigned long _earliest(const Slot& slot);
+};
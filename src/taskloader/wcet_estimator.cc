@@ -0,0 +1,110 @@
+#include "wcet_estimator.h"
+
+Wcet_estimator::Config::Config(const Genode::Xml_node& config) :
+	push{false},
+	min_jobs{20},
+	push_every{10},
+	percentile{99},
+	margin{10}
+{
+	if (!config.has_sub_node("wcet-estimate"))
+	{
+		return;
+	}
+	const Genode::Xml_node node = config.sub_node("wcet-estimate");
+	push = node.attribute_value<bool>("push", push);
+	min_jobs = node.attribute_value<unsigned>("min-jobs", min_jobs);
+	push_every = node.attribute_value<unsigned>("push-every", push_every);
+	percentile = node.attribute_value<unsigned>("percentile", percentile);
+	margin = node.attribute_value<unsigned>("margin", margin);
+
+	if (min_jobs == 0)
+	{
+		min_jobs = 1;
+	}
+	if (push_every == 0)
+	{
+		push_every = 1;
+	}
+	if (percentile > 100)
+	{
+		percentile = 100;
+	}
+}
+
+
+
+Wcet_estimator::Wcet_estimator() :
+	_histogram{},
+	_average{0}
+{
+}
+
+void Wcet_estimator::add(Genode::uint64_t cpu_time_us)
+{
+	_histogram.add(cpu_time_us);
+	if (_histogram.data().count == 1)
+	{
+		_average = cpu_time_us;
+	}
+	else
+	{
+		_average = _average - _average / 8 + cpu_time_us / 8;
+	}
+}
+
+void Wcet_estimator::reset()
+{
+	_histogram.reset();
+	_average = 0;
+}
+
+const Latency_histogram& Wcet_estimator::histogram() const
+{
+	return _histogram;
+}
+
+Genode::uint64_t Wcet_estimator::average() const
+{
+	return _average;
+}
+
+Genode::uint64_t Wcet_estimator::percentile(unsigned percent) const
+{
+	const Timing_snapshot::Histogram& data = _histogram.data();
+	if (data.count == 0)
+	{
+		return 0;
+	}
+
+	// Walk up to the bucket holding the rank, overflows lie above all buckets.
+	const Genode::uint64_t rank = ((Genode::uint64_t)data.count * percent + 99) / 100;
+	Genode::uint64_t seen = 0;
+	for (unsigned bucket = 0; bucket < Timing_snapshot::NUM_BUCKETS; ++bucket)
+	{
+		seen += data.buckets[bucket];
+		if (seen >= rank && seen > 0)
+		{
+			const Genode::uint64_t upper = bucket + 1 < Timing_snapshot::NUM_BUCKETS ? Timing_snapshot::bucket_min(bucket + 1) - 1 : data.max;
+			return upper < data.max ? upper : data.max;
+		}
+	}
+	return data.max;
+}
+
+unsigned Wcet_estimator::estimate(const Config& config) const
+{
+	if (_histogram.data().count < config.min_jobs)
+	{
+		return 0;
+	}
+
+	Genode::uint64_t us = percentile(config.percentile);
+	if (_average > us)
+	{
+		us = _average;
+	}
+	us = us * (100 + config.margin) / 100;
+	const Genode::uint64_t ms = (us + 999) / 1000;
+	return ms > 0 ? (unsigned)ms : 1;
+}
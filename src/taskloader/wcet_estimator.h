@@ -0,0 +1,52 @@
+#pragma once
+
+#include <base/stdint.h>
+#include <util/xml_node.h>
+
+#include "latency_histogram.h"
+
+// Observed CPU time per job of a task, with a WCET estimate derived from it.
+// Keeps the maximum and a histogram for percentiles, and an exponential moving average that follows recent jobs.
+// Not thread-safe, Task guards its estimator with Task::Shared_data::log_lock.
+class Wcet_estimator
+{
+public:
+	// Options of the <wcet-estimate> config node.
+	struct Config
+	{
+		Config(const Genode::Xml_node& config);
+
+		// Offer refined estimates to the controller in place of the specified execution time ("push").
+		bool push;
+
+		// Jobs observed before the first estimate ("min-jobs") and between two pushes ("push-every").
+		unsigned min_jobs;
+		unsigned push_every;
+
+		// Percentile of the CPU times the estimate is based on ("percentile").
+		unsigned percentile;
+
+		// Safety margin added to the estimate in percent ("margin").
+		unsigned margin;
+	};
+
+	Wcet_estimator();
+
+	void add(Genode::uint64_t cpu_time_us);
+	void reset();
+
+	const Latency_histogram& histogram() const;
+
+	// Moving average over the recent jobs in us, weight 1/8 for the latest one.
+	Genode::uint64_t average() const;
+
+	// Upper bound of the CPU time of percent of all jobs in us.
+	Genode::uint64_t percentile(unsigned percent) const;
+
+	// Estimated WCET in ms: the larger of the percentile and the moving average plus the margin, rounded up. 0 until min_jobs have been observed.
+	unsigned estimate(const Config& config) const;
+
+protected:
+	Latency_histogram _histogram;
+	Genode::uint64_t _average;
+};
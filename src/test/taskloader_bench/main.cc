@@ -0,0 +1,199 @@
+#include <base/env.h>
+#include <base/printf.h>
+#include <dataspace/client.h>
+#include <os/attached_ram_dataspace.h>
+#include <rom_session/connection.h>
+#include <taskloader/taskloader_connection.h>
+#include <taskloader/timing_snapshot.h>
+#include <timer_session/connection.h>
+#include <util/string.h>
+
+// Benchmark of the taskloader hot paths, see run/taskloader_bench.run.
+// Durations are taken from the operation costs in the timing snapshot of the taskloader, which are measured in us on the server side.
+// Each result is printed as a single line "bench <name> key=value ...", so the log can be parsed and compared between runs.
+
+enum
+{
+	ADD_REPETITIONS = 10,
+	UPLOAD_REPETITIONS = 10,
+	PERIOD_MS = 10,
+	JOBS = 20,
+	TASK_XML_SIZE = 512
+};
+
+static const char* const TASK_BINARY = "taskloader_bench_task";
+
+// Operation costs accumulated by the taskloader so far.
+struct Costs
+{
+	Timing_snapshot::Histogram operations[Timing_snapshot::NUM_OPERATIONS];
+
+	void print_delta(const Costs& before, Timing_snapshot::Operation op, const char* name, const char* param, unsigned value, unsigned items_per_op) const
+	{
+		const Genode::uint32_t count = operations[op].count - before.operations[op].count;
+		const Genode::uint64_t total = operations[op].total - before.operations[op].total;
+		const unsigned long long avg = count > 0 ? total / count : 0;
+		const unsigned long long per_s = avg > 0 ? 1000000ull * items_per_op / avg : 0;
+		Genode::printf("bench %s %s=%u count=%u avg_us=%llu per_s=%llu\n", name, param, value, count, avg, per_s);
+	}
+};
+
+static void snapshot(Taskloader_connection& taskloader, Costs& costs, Timing_snapshot::Histogram* release_latency = nullptr)
+{
+	Genode::Rm_session* rm = Genode::env()->rm_session();
+	const Timing_snapshot::Header* header = rm->attach(taskloader.timing_ds());
+	Genode::memcpy(costs.operations, header->operations, sizeof(costs.operations));
+
+	// Combine the release latencies of all tasks.
+	if (release_latency)
+	{
+		*release_latency = Timing_snapshot::Histogram();
+		const char* entries = reinterpret_cast<const char*>(header + 1);
+		for (Genode::uint32_t i = 0; i < header->num_tasks; ++i)
+		{
+			const Timing_snapshot::Histogram& latency = reinterpret_cast<const Timing_snapshot::Task_entry*>(entries + i * header->entry_size)->release_latency;
+			if (latency.count == 0)
+			{
+				continue;
+			}
+			if (release_latency->count == 0 || latency.min < release_latency->min)
+			{
+				release_latency->min = latency.min;
+			}
+			if (latency.max > release_latency->max)
+			{
+				release_latency->max = latency.max;
+			}
+			release_latency->count += latency.count;
+			release_latency->total += latency.total;
+		}
+	}
+	rm->detach(header);
+}
+
+// Task set of num_tasks periodic tasks running the benchmark task.
+static void add_tasks(Taskloader_connection& taskloader, unsigned num_tasks, unsigned number_of_jobs)
+{
+	Genode::Attached_ram_dataspace xml(Genode::env()->ram_session(), num_tasks * TASK_XML_SIZE + 64);
+	char* out = xml.local_addr<char>();
+	char* const end = out + xml.size();
+
+	out += Genode::snprintf(out, end - out, "<taskset>");
+	for (unsigned id = 1; id <= num_tasks; ++id)
+	{
+		out += Genode::snprintf(out, end - out,
+			"<periodictask><id>%u</id><executiontime>1</executiontime><criticaltime>0</criticaltime>"
+			"<priority>%u</priority><deadline>0</deadline><period>%u</period><offset>0</offset>"
+			"<numberofjobs>%u</numberofjobs><quota>1M</quota><pkg>%s</pkg><config/></periodictask>",
+			id, 64 + id % 64, PERIOD_MS, number_of_jobs, TASK_BINARY);
+	}
+	Genode::snprintf(out, end - out, "</taskset>");
+
+	taskloader.add_tasks(xml.cap());
+}
+
+static Genode::Ram_dataspace_capability upload(Taskloader_connection& taskloader, const char* name, const void* content, size_t size)
+{
+	Genode::Attached_ram_dataspace name_ds(Genode::env()->ram_session(), Genode::strlen(name) + 1);
+	Genode::strncpy(name_ds.local_addr<char>(), name, name_ds.size());
+
+	Genode::Ram_dataspace_capability ds = taskloader.binary_ds(name_ds.cap(), size);
+	Genode::Rm_session* rm = Genode::env()->rm_session();
+	char* dst = rm->attach(ds);
+	if (content)
+	{
+		Genode::memcpy(dst, content, size);
+	}
+	else
+	{
+		Genode::memset(dst, 0, size);
+	}
+	rm->detach(dst);
+	return ds;
+}
+
+static void bench_add_tasks(Taskloader_connection& taskloader)
+{
+	static const unsigned sizes[] = { 1, 10, 100, 1000 };
+	for (unsigned num_tasks : sizes)
+	{
+		Costs before;
+		snapshot(taskloader, before);
+		for (unsigned i = 0; i < ADD_REPETITIONS; ++i)
+		{
+			add_tasks(taskloader, num_tasks, 0);
+			taskloader.clear_tasks();
+		}
+		Costs after;
+		snapshot(taskloader, after);
+		after.print_delta(before, Timing_snapshot::OP_ADD_TASKS, "add_tasks", "tasks", num_tasks, num_tasks);
+		after.print_delta(before, Timing_snapshot::OP_CLEAR_TASKS, "clear_tasks", "tasks", num_tasks, num_tasks);
+	}
+}
+
+static void bench_binary_ds(Taskloader_connection& taskloader)
+{
+	static const unsigned sizes_kib[] = { 4, 64, 1024, 4096 };
+	for (unsigned size_kib : sizes_kib)
+	{
+		char name[32];
+		Costs before;
+		snapshot(taskloader, before);
+		for (unsigned i = 0; i < UPLOAD_REPETITIONS; ++i)
+		{
+			Genode::snprintf(name, sizeof(name), "bench_%u_%u", size_kib, i);
+			upload(taskloader, name, nullptr, size_kib * 1024);
+			Genode::Attached_ram_dataspace name_ds(Genode::env()->ram_session(), sizeof(name));
+			Genode::strncpy(name_ds.local_addr<char>(), name, name_ds.size());
+			taskloader.release_binary(name_ds.cap());
+		}
+		Costs after;
+		snapshot(taskloader, after);
+		after.print_delta(before, Timing_snapshot::OP_BINARY_DS, "binary_ds", "kib", size_kib, 1);
+	}
+}
+
+// Release latency of the job starts and cost of sampling the trace subjects on each event, with more subjects as more tasks run.
+static void bench_release(Taskloader_connection& taskloader, Timer::Connection& timer)
+{
+	static const unsigned sizes[] = { 1, 4, 16 };
+	for (unsigned num_tasks : sizes)
+	{
+		Costs before;
+		snapshot(taskloader, before);
+
+		add_tasks(taskloader, num_tasks, JOBS);
+		taskloader.start();
+		timer.msleep(PERIOD_MS * (JOBS + 5) + 100);
+		taskloader.stop();
+
+		Costs after;
+		Timing_snapshot::Histogram latency;
+		snapshot(taskloader, after, &latency);
+		taskloader.clear_tasks();
+
+		Genode::printf("bench release tasks=%u count=%u min_us=%llu avg_us=%llu max_us=%llu\n", num_tasks, latency.count,
+			latency.count > 0 ? latency.min : 0, latency.count > 0 ? latency.total / latency.count : 0, latency.max);
+		after.print_delta(before, Timing_snapshot::OP_LOG_EVENT, "log_event", "tasks", num_tasks, 1);
+	}
+}
+
+int main()
+{
+	Taskloader_connection taskloader;
+	Timer::Connection timer;
+
+	// The binary for the release benchmark stays uploaded for the whole run.
+	Genode::Rom_connection rom(TASK_BINARY);
+	Genode::Rm_session* rm = Genode::env()->rm_session();
+	const void* binary = rm->attach(rom.dataspace());
+	upload(taskloader, TASK_BINARY, binary, Genode::Dataspace_client(rom.dataspace()).size());
+	rm->detach(binary);
+
+	bench_add_tasks(taskloader);
+	bench_binary_ds(taskloader);
+	bench_release(taskloader, timer);
+
+	Genode::printf("bench done\n");
+	return 0;
+}
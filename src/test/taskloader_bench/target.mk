@@ -0,0 +1,3 @@
+TARGET = taskloader_bench
+SRC_CC = main.cc
+LIBS = base
@@ -0,0 +1,5 @@
+// Job of the release latency benchmark, exits right away.
+int main()
+{
+	return 0;
+}
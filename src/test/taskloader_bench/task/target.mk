@@ -0,0 +1,3 @@
+TARGET = taskloader_bench_task
+SRC_CC = main.cc
+LIBS = base